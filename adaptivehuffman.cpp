@@ -0,0 +1,386 @@
+/* File: adaptivehuffman.cpp
+ * Assignment brief: one-pass Huffman coding for live streams. The header file,
+ * "adaptivehuffman.h" is in this repository, along with a description of the layout.
+ */
+#include "adaptivehuffman.h"
+#include "byteio.h"
+#include "error.h"
+#include "filelib.h"
+#include "histogram.h"
+#include "random.h"
+#include "strlib.h"
+#include <algorithm>
+#include <sstream>
+#include "testing/SimpleTest.h"
+using namespace std;
+
+const string kAdaptiveMagic = "HFA1";
+const int kFirstRebuildInterval = 16;
+const int64_t kAdaptiveCountLimit = 1 << 16;
+
+AdaptiveModel::AdaptiveModel(int rebuildInterval) {
+    if (rebuildInterval < 1 || rebuildInterval > kMaxBlockSize) {
+        error("AdaptiveModel: rebuildInterval must be between 1 and kMaxBlockSize");
+    }
+    for (int b = 0; b < 256; b++) {
+        _counts[b] = 1;
+        _lengths[b] = 8;
+    }
+    _total = 256;
+    _rebuildInterval = rebuildInterval;
+    _interval = min(kFirstRebuildInterval, rebuildInterval);
+    _untilRebuild = _interval;
+}
+
+const uint8_t* AdaptiveModel::lengths() const {
+    return _lengths;
+}
+
+int AdaptiveModel::untilRebuild() const {
+    return _untilRebuild;
+}
+
+/*
+ * Halving rounds up, so no count drops to 0 and every byte value keeps a code.
+ */
+bool AdaptiveModel::update(const char* data, size_t size) {
+    int64_t counts[256];
+    histogram(data, size, counts);
+    for (int b = 0; b < 256; b++) {
+        _counts[b] += counts[b];
+    }
+    _total += size;
+    _untilRebuild -= size;
+    if (_untilRebuild > 0) {
+        return false;
+    }
+
+    if (_total > kAdaptiveCountLimit) {
+        _total = 0;
+        for (int b = 0; b < 256; b++) {
+            _counts[b] = (_counts[b] + 1) / 2;
+            _total += _counts[b];
+        }
+    }
+    limitedCodeLengthsFromCounts(_counts, kDefaultCodeLengthLimit, _lengths);
+    _interval = min(2 * _interval, _rebuildInterval);
+    _untilRebuild = _interval;
+    return true;
+}
+
+AdaptiveEncoder::AdaptiveEncoder(int rebuildInterval) : _model(rebuildInterval),
+                                                        _table(_model.lengths()) {
+}
+
+/*
+ * Each run up to the next rebuild point is encoded by one HuffmanEncodeTable::encode call.
+ */
+void AdaptiveEncoder::encode(const char* data, size_t size, BitBuffer& out) {
+    while (size > 0) {
+        size_t run = min(size, (size_t) _model.untilRebuild());
+        _table.encode(data, run, out);
+        if (_model.update(data, run)) {
+            _table = HuffmanEncodeTable(_model.lengths());
+        }
+        data += run;
+        size -= run;
+    }
+}
+
+void AdaptiveEncoder::encode(const string& text, BitBuffer& out) {
+    encode(text.data(), text.size(), out);
+}
+
+AdaptiveDecoder::AdaptiveDecoder(int rebuildInterval) : _model(rebuildInterval) {
+    _table = new CanonicalDecoder(_model.lengths(), kDefaultCodeLengthLimit);
+}
+
+AdaptiveDecoder::~AdaptiveDecoder() {
+    delete _table;
+}
+
+void AdaptiveDecoder::decode(BitReader& bits, char* out, int64_t count) {
+    while (count > 0) {
+        int64_t run = min(count, (int64_t) _model.untilRebuild());
+        _table->decode(bits, out, run);
+        if (_model.update(out, run)) {
+            delete _table;
+            _table = new CanonicalDecoder(_model.lengths(), kDefaultCodeLengthLimit);
+        }
+        out += run;
+        count -= run;
+    }
+}
+
+AdaptiveStreamWriter::AdaptiveStreamWriter(ostream& out, int rebuildInterval)
+        : _out(out), _encoder(rebuildInterval), _closed(false) {
+    string header = kAdaptiveMagic;
+    appendU32(header, rebuildInterval);
+    _out.write(header.data(), header.size());
+}
+
+AdaptiveStreamWriter::~AdaptiveStreamWriter() {
+    if (!_closed) {
+        close();
+    }
+}
+
+void AdaptiveStreamWriter::write(const char* data, size_t size) {
+    if (_closed) {
+        error("AdaptiveStreamWriter: write after close");
+    }
+    while (size > 0) {
+        size_t frameSize = min(size, (size_t) kMaxBlockSize);
+        BitBuffer bits;
+        _encoder.encode(data, frameSize, bits);
+        string frame;
+        appendU32(frame, frameSize);
+        appendU32(frame, (bits.size() + 7) / 8);
+        bits.appendBytes(frame);
+        _out.write(frame.data(), frame.size());
+        data += frameSize;
+        size -= frameSize;
+    }
+    _out.flush();
+}
+
+void AdaptiveStreamWriter::write(const string& data) {
+    write(data.data(), data.size());
+}
+
+void AdaptiveStreamWriter::close() {
+    if (_closed) {
+        error("AdaptiveStreamWriter: already closed");
+    }
+    _closed = true;
+    string end;
+    appendU32(end, 0);
+    _out.write(end.data(), end.size());
+    _out.flush();
+}
+
+/* HELPER FUNCTION: reads exactly n bytes from in into buffer. */
+static void readExactly(istream& in, string& buffer, size_t n) {
+    buffer.resize(n);
+    if (n > 0 && !in.read(&buffer[0], n)) {
+        error("AdaptiveStreamReader: truncated stream");
+    }
+}
+
+/* HELPER FUNCTION: reads and checks the stream header, and returns its rebuild interval. */
+static int readAdaptiveHeader(istream& in) {
+    string header;
+    readExactly(in, header, 8);
+    if (header.substr(0, 4) != kAdaptiveMagic) {
+        error("AdaptiveStreamReader: not an adaptive stream");
+    }
+    uint32_t rebuildInterval = readU32(header.data(), 4);
+    if (rebuildInterval < 1 || rebuildInterval > (uint32_t) kMaxBlockSize) {
+        error("AdaptiveStreamReader: bad rebuild interval");
+    }
+    return rebuildInterval;
+}
+
+AdaptiveStreamReader::AdaptiveStreamReader(istream& in)
+        : _in(in), _decoder(readAdaptiveHeader(in)), _ended(false) {
+}
+
+/*
+ * No code is longer than kDefaultCodeLengthLimit bits, which bounds payloadLength by
+ * rawLength before anything is allocated. The payload must end in the last byte the codes
+ * reach into, so padding can be at most 7 bits.
+ */
+bool AdaptiveStreamReader::read(string& data) {
+    data.clear();
+    if (_ended) {
+        return false;
+    }
+    string buffer;
+    readExactly(_in, buffer, 4);
+    uint32_t rawLength = readU32(buffer.data(), 0);
+    if (rawLength == 0) {
+        _ended = true;
+        return false;
+    }
+    readExactly(_in, buffer, 4);
+    uint32_t payloadLength = readU32(buffer.data(), 0);
+    if (rawLength > (uint32_t) kMaxBlockSize
+            || payloadLength > ((uint64_t) rawLength * kDefaultCodeLengthLimit + 7) / 8) {
+        error("AdaptiveStreamReader: bad frame length");
+    }
+    readExactly(_in, buffer, payloadLength);
+    BitBuffer bits = BitBuffer::fromBytes(buffer.data(), (int64_t) payloadLength * 8);
+    BitReader reader(bits);
+    data.resize(rawLength);
+    _decoder.decode(reader, &data[0], rawLength);
+    if (reader.remaining() >= 8) {
+        error("AdaptiveStreamReader: frame has extra bytes");
+    }
+    return true;
+}
+
+void compressAdaptive(istream& in, ostream& out, int frameSize, int rebuildInterval) {
+    if (frameSize < 1 || frameSize > kMaxBlockSize) {
+        error("compressAdaptive: frameSize must be between 1 and kMaxBlockSize");
+    }
+    AdaptiveStreamWriter writer(out, rebuildInterval);
+    string frame(frameSize, '\0');
+    while (true) {
+        in.read(&frame[0], frameSize);
+        streamsize got = in.gcount();
+        writer.write(frame.data(), got);
+        if (got < frameSize) {
+            break;
+        }
+    }
+    writer.close();
+}
+
+void decompressAdaptive(istream& in, ostream& out) {
+    AdaptiveStreamReader reader(in);
+    string frame;
+    while (reader.read(frame)) {
+        out.write(frame.data(), frame.size());
+    }
+    out.flush();
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * */
+
+STUDENT_TEST("AdaptiveModel: starts flat, rebuilds on schedule, keeps every byte value") {
+    AdaptiveModel model(100);
+    for (int b = 0; b < 256; b++) {
+        EXPECT_EQUAL(model.lengths()[b], 8);
+    }
+    string text = readEntireFile("res/dream.txt");
+    size_t pos = 0;
+    for (int expected : { 16, 32, 64, 100, 100, 100 }) {
+        EXPECT_EQUAL(model.untilRebuild(), expected);
+        EXPECT(!model.update(text.data() + pos, expected - 1));
+        EXPECT(model.update(text.data() + pos + expected - 1, 1));
+        pos += expected;
+    }
+    for (int b = 0; b < 256; b++) {
+        EXPECT(model.lengths()[b] >= 1);
+        EXPECT(model.lengths()[b] <= kDefaultCodeLengthLimit);
+    }
+    EXPECT(model.lengths()[(unsigned char) 'e'] < model.lengths()[(unsigned char) 'q']);
+    EXPECT_ERROR(AdaptiveModel bad(0));
+}
+
+STUDENT_TEST("AdaptiveEncoder / AdaptiveDecoder: same bits however the input is split") {
+    string text = readEntireFile("res/constitution.txt");
+    for (int rebuildInterval : { 1, 7, kDefaultRebuildInterval }) {
+        BitBuffer whole;
+        AdaptiveEncoder(rebuildInterval).encode(text, whole);
+
+        AdaptiveEncoder encoder(rebuildInterval);
+        BitBuffer pieces;
+        for (size_t pos = 0; pos < text.size(); ) {
+            size_t size = min(text.size() - pos, (size_t) randomInteger(0, 3000));
+            encoder.encode(text.data() + pos, size, pieces);
+            pos += size;
+        }
+        EXPECT(pieces == whole);
+
+        AdaptiveDecoder decoder(rebuildInterval);
+        BitReader reader(whole);
+        string decoded(text.size(), '\0');
+        for (size_t pos = 0; pos < text.size(); ) {
+            size_t size = min(text.size() - pos, (size_t) randomInteger(0, 3000));
+            decoder.decode(reader, &decoded[pos], size);
+            pos += size;
+        }
+        EXPECT_EQUAL(decoded, text);
+        EXPECT_EQUAL(reader.remaining(), 0);
+    }
+}
+
+STUDENT_TEST("AdaptiveStreamWriter / Reader: frames arrive as written, and bad streams") {
+    string text = readEntireFile("res/dream.txt");
+    ostringstream out;
+    AdaptiveStreamWriter writer(out);
+    Vector<string> written;
+    for (size_t pos = 0; pos < text.size(); ) {
+        size_t size = min(text.size() - pos, (size_t) randomInteger(1, 500));
+        written.add(text.substr(pos, size));
+        writer.write(text.substr(pos, size));
+        writer.write("");
+        pos += size;
+    }
+    writer.close();
+    EXPECT_ERROR(writer.write("x"));
+
+    istringstream in(out.str());
+    AdaptiveStreamReader reader(in);
+    string frame;
+    for (const string& expected : written) {
+        EXPECT(reader.read(frame));
+        EXPECT_EQUAL(frame, expected);
+    }
+    EXPECT(!reader.read(frame));
+    EXPECT(!reader.read(frame));
+
+    string bytes = out.str();
+    auto decompressBytes = [](const string& bytes) {
+        istringstream in(bytes);
+        ostringstream out;
+        decompressAdaptive(in, out);
+        return out.str();
+    };
+    EXPECT_EQUAL(decompressBytes(bytes), text);
+    EXPECT_ERROR(decompressBytes(bytes.substr(0, bytes.size() / 2)));
+    EXPECT_ERROR(decompressBytes("HFS1" + bytes.substr(4)));
+    string corrupt = bytes;
+    corrupt[12] = (char) 0xFF;  // payload length of the first frame
+    EXPECT_ERROR(decompressBytes(corrupt));
+}
+
+STUDENT_TEST("compressAdaptive (one pass) vs compressStream (two passes per block)") {
+    string base = readEntireFile("res/constitution.txt");
+    string drifting;    // text, then the same text with its letters shifted to other bytes
+    for (int i = 0; i < 8; i++) {
+        drifting += base;
+    }
+    for (int i = 0; i < 8; i++) {
+        for (char ch : base) {
+            drifting += isalpha(ch) ? (char) (ch + 128) : ch;
+        }
+    }
+    string text;
+    while (text.size() < (16 << 20)) {
+        text += base;
+    }
+
+    for (string name : { "text", "drifting" }) {
+        const string& input = (name == "text") ? text : drifting;
+        cout << "    " << name << ", " << input.size() << " bytes:" << endl;
+        for (int frameSize : { 64, 4096, kDefaultAdaptiveFrameSize }) {
+            istringstream in(input);
+            ostringstream out;
+            compressAdaptive(in, out, frameSize);
+            istringstream back(out.str());
+            ostringstream restored;
+            decompressAdaptive(back, restored);
+            EXPECT(restored.str() == input);
+            cout << "      adaptive, " << frameSize << "-byte frames: " << out.str().size()
+                 << " bytes" << endl;
+        }
+        istringstream in(input);
+        ostringstream out;
+        compressStream(in, out);
+        cout << "      compressStream, 1 MB blocks: " << out.str().size() << " bytes" << endl;
+    }
+
+    istringstream adaptiveIn(text), streamIn(text);
+    ostringstream adaptiveOut, streamOut;
+    TIME_OPERATION(text.size(), compressAdaptive(adaptiveIn, adaptiveOut));
+    TIME_OPERATION(text.size(), compressStream(streamIn, streamOut));
+    istringstream adaptiveBack(adaptiveOut.str()), streamBack(streamOut.str());
+    ostringstream fromAdaptive, fromStream;
+    TIME_OPERATION(text.size(), decompressAdaptive(adaptiveBack, fromAdaptive));
+    TIME_OPERATION(text.size(), decompressStream(streamBack, fromStream));
+    EXPECT(fromAdaptive.str() == text);
+    EXPECT(fromStream.str() == text);
+}
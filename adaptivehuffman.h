@@ -0,0 +1,197 @@
+/* File: adaptivehuffman.h
+ * Assignment brief: one-pass Huffman coding for live streams. compress needs the whole
+ * message up front to count it. Here the encoder and decoder both start from the same
+ * flat model and keep the same running byte counts, and every so many bytes they rebuild
+ * the same canonical code from those counts (a periodically rebuilt semi-static model).
+ * No code lengths are ever sent, and any prefix of the input can be encoded, sent and
+ * decoded before the rest of it exists.
+ *
+ * Stream layout (integers are little-endian u32):
+ *
+ *     stream := "HFA1" rebuildInterval frame* 0
+ *     frame  := rawLength payloadLength payload{payloadLength}
+ *
+ * Each frame is the bits of the next rawLength bytes, padded to a whole byte. rawLength
+ * is never 0, and the model carries over from one frame to the next.
+ */
+#pragma once
+#include "testing/MemoryUtils.h"
+#include "bitbuffer.h"
+#include "canonical.h"
+#include "huffmanencode.h"
+#include "huffmanstream.h"
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+/**
+ * Default number of bytes between code rebuilds, once the model has warmed up.
+ */
+const int kDefaultRebuildInterval = 16384;
+
+/**
+ * Default frame size for compressAdaptive.
+ */
+const int kDefaultAdaptiveFrameSize = 1 << 16;
+
+/**
+ * The model shared by AdaptiveEncoder and AdaptiveDecoder: every byte value starts with a
+ * count of 1, so all of them can be coded from the first byte on. The code is rebuilt
+ * after 16 bytes, then after intervals that double up to rebuildInterval, so the model
+ * settles quickly and then costs little. Codes are limited to kDefaultCodeLengthLimit
+ * bits. When the counts pass a total of 2^16 they are halved, so the code follows data
+ * whose statistics drift.
+ */
+class AdaptiveModel {
+public:
+    /**
+     * Reports an error if rebuildInterval is not between 1 and kMaxBlockSize.
+     */
+    AdaptiveModel(int rebuildInterval = kDefaultRebuildInterval);
+
+    /**
+     * Returns the code lengths currently in use.
+     */
+    const uint8_t* lengths() const;
+
+    /**
+     * Returns how many more bytes are coded with the current lengths.
+     */
+    int untilRebuild() const;
+
+    /**
+     * Counts data[0 .. size), where size is at most untilRebuild(). Returns true if this
+     * reached the rebuild point and the lengths changed.
+     */
+    bool update(const char* data, size_t size);
+
+private:
+    int64_t _counts[256];
+    int64_t _total;
+    uint8_t _lengths[256];
+    int _rebuildInterval;
+    int _interval;          // length of the current interval
+    int _untilRebuild;
+};
+
+/**
+ * Encodes bytes as they arrive, using and updating an AdaptiveModel.
+ */
+class AdaptiveEncoder {
+public:
+    AdaptiveEncoder(int rebuildInterval = kDefaultRebuildInterval);
+
+    /**
+     * Appends the codes of data[0 .. size) to out. Splitting the input over several calls
+     * gives the same bits as one call.
+     */
+    void encode(const char* data, size_t size, BitBuffer& out);
+    void encode(const std::string& text, BitBuffer& out);
+
+private:
+    AdaptiveModel _model;
+    HuffmanEncodeTable _table;
+};
+
+/**
+ * Decodes what AdaptiveEncoder wrote, given the same rebuildInterval.
+ */
+class AdaptiveDecoder {
+public:
+    AdaptiveDecoder(int rebuildInterval = kDefaultRebuildInterval);
+    ~AdaptiveDecoder();
+
+    /**
+     * Decodes the next count bytes from bits into out[0 .. count).
+     *
+     * Reports an error if the bits are not codes or run out first.
+     */
+    void decode(BitReader& bits, char* out, int64_t count);
+
+private:
+    AdaptiveModel _model;
+    CanonicalDecoder* _table;
+
+    DISALLOW_COPYING_OF(AdaptiveDecoder);
+};
+
+/**
+ * Writes an adaptive stream. Every write becomes one frame (or more, past kMaxBlockSize
+ * bytes) and is flushed to out right away, so the reader is never more than one write
+ * behind.
+ */
+class AdaptiveStreamWriter {
+public:
+    /**
+     * Writes the stream header to out.
+     */
+    AdaptiveStreamWriter(std::ostream& out, int rebuildInterval = kDefaultRebuildInterval);
+
+    /**
+     * Calls close() if it hasn't been called yet.
+     */
+    ~AdaptiveStreamWriter();
+
+    /**
+     * Encodes data[0 .. size) and writes it out as a frame. Writing nothing writes nothing.
+     */
+    void write(const char* data, size_t size);
+    void write(const std::string& data);
+
+    /**
+     * Writes the end marker. Nothing may be written after this.
+     */
+    void close();
+
+private:
+    std::ostream& _out;
+    AdaptiveEncoder _encoder;
+    bool _closed;
+
+    DISALLOW_COPYING_OF(AdaptiveStreamWriter);
+};
+
+/**
+ * Reads an adaptive stream one frame at a time.
+ */
+class AdaptiveStreamReader {
+public:
+    /**
+     * Reads the stream header from in.
+     *
+     * Reports an error if in does not start with a valid header.
+     */
+    AdaptiveStreamReader(std::istream& in);
+
+    /**
+     * Reads and decodes the next frame into data. Returns false, and leaves data empty,
+     * at the end marker.
+     *
+     * Reports an error if the frame is truncated or corrupt.
+     */
+    bool read(std::string& data);
+
+private:
+    std::istream& _in;
+    AdaptiveDecoder _decoder;
+    bool _ended;
+
+    DISALLOW_COPYING_OF(AdaptiveStreamReader);
+};
+
+/**
+ * Reads in until it runs out and writes it to out as an adaptive stream, frameSize bytes
+ * per frame.
+ *
+ * Reports an error if frameSize is not between 1 and kMaxBlockSize.
+ */
+void compressAdaptive(std::istream& in, std::ostream& out, int frameSize = kDefaultAdaptiveFrameSize,
+                      int rebuildInterval = kDefaultRebuildInterval);
+
+/**
+ * Reads an adaptive stream from in and writes the original bytes to out.
+ *
+ * Reports an error if in is not a valid adaptive stream.
+ */
+void decompressAdaptive(std::istream& in, std::ostream& out);
@@ -0,0 +1,127 @@
+/* File: binaryheap.h
+ * Assignment brief: a binary min-heap template with the same interface as PQHeap, for
+ * priority queues of elements other than DataPoint. PQHeap keeps its own implementation.
+ */
+#pragma once
+#include "testing/MemoryUtils.h"
+#include "error.h"
+
+/**
+ * Priority queue of T implemented using a binary min-heap, ordered by priorityOf(element).
+ * It has the same interface as PQHeap, so offerTopK and drainDescending work on it too.
+ */
+template <typename T, int (*priorityOf)(const T&)>
+class BinaryHeap {
+public:
+    /**
+     * Creates a new, empty priority queue.
+     */
+    BinaryHeap() {
+        _numAllocated = 10;
+        _heap = new T[_numAllocated];
+        _numFilled = 0;
+    }
+
+    ~BinaryHeap() {
+        delete[] _heap;
+    }
+
+    /**
+     * Adds a new element into the queue. This operation runs in time O(log n).
+     */
+    void enqueue(const T& element) {
+        if (_numFilled == _numAllocated) {
+            T* bigger = new T[_numAllocated * 2];
+            for (int i = 0; i < _numFilled; i++) {
+                bigger[i] = _heap[i];
+            }
+            delete[] _heap;
+            _heap = bigger;
+            _numAllocated *= 2;
+        }
+        _heap[_numFilled] = element;
+        _numFilled++;
+        bubbleUp();
+    }
+
+    /**
+     * Removes and returns the element with the lowest priority value.
+     *
+     * If the priority queue is empty, this function calls error().
+     */
+    T dequeue() {
+        if (isEmpty()) {
+            error("Cannot dequeue empty heap!");
+        }
+        T front = _heap[0];
+        _numFilled--;
+        if (_numFilled > 0) {
+            _heap[0] = _heap[_numFilled];
+            bubbleDown();
+        }
+        return front;
+    }
+
+    /**
+     * Returns, but does not remove, the element with the lowest priority value.
+     *
+     * If the priority queue is empty, this function calls error().
+     */
+    T peek() const {
+        if (isEmpty()) {
+            error("Cannot peek empty heap!");
+        }
+        return _heap[0];
+    }
+
+    bool isEmpty() const {
+        return _numFilled == 0;
+    }
+
+    int size() const {
+        return _numFilled;
+    }
+
+    /**
+     * Removes all elements from the priority queue. This operation runs in time O(1).
+     */
+    void clear() {
+        _numFilled = 0;
+    }
+
+private:
+    T* _heap;
+    int _numAllocated;
+    int _numFilled;
+
+    /* 'bubbling up' for enqueue. Moves the hole up instead of swapping. */
+    void bubbleUp() {
+        int index = _numFilled - 1;
+        T elem = _heap[index];
+        while (index > 0 && priorityOf(_heap[(index - 1) / 2]) > priorityOf(elem)) {
+            _heap[index] = _heap[(index - 1) / 2];
+            index = (index - 1) / 2;
+        }
+        _heap[index] = elem;
+    }
+
+    /* 'bubbling down' for dequeue. Moves the hole down instead of swapping. */
+    void bubbleDown() {
+        int index = 0;
+        T elem = _heap[0];
+        while (2 * index + 1 < _numFilled) {
+            int child = 2 * index + 1;
+            if (child + 1 < _numFilled && priorityOf(_heap[child + 1]) < priorityOf(_heap[child])) {
+                child++;
+            }
+            if (priorityOf(_heap[child]) >= priorityOf(elem)) {
+                break;
+            }
+            _heap[index] = _heap[child];
+            index = child;
+        }
+        _heap[index] = elem;
+    }
+
+    DISALLOW_COPYING_OF(BinaryHeap);
+};
@@ -0,0 +1,424 @@
+/* File: bitbuffer.cpp
+ * Assignment brief: packed bit buffer for encoded Huffman data. The header file,
+ * "bitbuffer.h" is in this repository.
+ */
+#include "bitbuffer.h"
+#include "huffmanencode.h"
+#include "huffmantable.h"
+#include "error.h"
+#include "filelib.h"
+#include "strlib.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+BitBuffer::BitBuffer() {
+    _numBits = 0;
+}
+
+int64_t BitBuffer::size() const {
+    return _numBits;
+}
+
+bool BitBuffer::isEmpty() const {
+    return _numBits == 0;
+}
+
+int BitBuffer::get(int64_t index) const {
+    if (index < 0 || index >= _numBits) {
+        error("BitBuffer: index out of range");
+    }
+    return (_words[index >> 6] >> (63 - (index & 63))) & 1;
+}
+
+void BitBuffer::clear() {
+    _words.clear();
+    _numBits = 0;
+}
+
+int64_t BitBuffer::bytesUsed() const {
+    return _words.size() * sizeof(uint64_t);
+}
+
+const vector<uint64_t>& BitBuffer::words() const {
+    return _words;
+}
+
+/*
+ * Whole words are done 8 bytes at a time with shifts of a fixed pattern, which compilers
+ * turn into a single byte swap; only the last partial word goes byte by byte.
+ */
+void BitBuffer::appendBytes(string& out) const {
+    int64_t numBytes = (_numBits + 7) / 8;
+    size_t at = out.size();
+    out.resize(at + numBytes);
+    unsigned char* bytes = (unsigned char*) &out[at];
+    int64_t fullWords = numBytes / 8;
+    for (int64_t w = 0; w < fullWords; w++) {
+        uint64_t word = _words[w];
+        for (int i = 0; i < 8; i++) {
+            bytes[8 * w + i] = (unsigned char) (word >> (56 - 8 * i));
+        }
+    }
+    for (int64_t i = fullWords * 8; i < numBytes; i++) {
+        bytes[i] = (unsigned char) (_words[i >> 3] >> (56 - 8 * (i & 7)));
+    }
+}
+
+BitBuffer BitBuffer::fromBytes(const char* data, int64_t numBits) {
+    const unsigned char* bytes = (const unsigned char*) data;
+    int64_t numBytes = (numBits + 7) / 8;
+    BitBuffer result;
+    result._words.assign((numBytes + 7) / 8, 0);
+    int64_t fullWords = numBytes / 8;
+    for (int64_t w = 0; w < fullWords; w++) {
+        uint64_t word = 0;
+        for (int i = 0; i < 8; i++) {
+            word = (word << 8) | bytes[8 * w + i];
+        }
+        result._words[w] = word;
+    }
+    for (int64_t i = fullWords * 8; i < numBytes; i++) {
+        result._words[i >> 3] |= (uint64_t) bytes[i] << (56 - 8 * (i & 7));
+    }
+    if (numBits & 63) {
+        result._words.back() &= ~0ULL << (64 - (numBits & 63));
+    }
+    result._numBits = numBits;
+    return result;
+}
+
+/* Unused bits of the last word are kept 0, so whole words can be compared. */
+bool BitBuffer::operator==(const BitBuffer& other) const {
+    return _numBits == other._numBits && _words == other._words;
+}
+
+bool BitBuffer::operator!=(const BitBuffer& other) const {
+    return !(*this == other);
+}
+
+ostream& operator<<(ostream& out, const BitBuffer& bits) {
+    out << "{";
+    for (int64_t i = 0; i < bits.size(); i++) {
+        out << (i > 0 ? ", " : "") << bits.get(i);
+    }
+    return out << "}";
+}
+
+BitWriter::BitWriter(BitBuffer& out) : _out(out) {
+    _acc = 0;
+    _accBits = 0;
+    reclaimPartialWord();
+}
+
+/* HELPER FUNCTION: if the buffer ends part way through a word, takes that word back into
+ * the accumulator so new bits continue right after the old ones.
+ */
+void BitWriter::reclaimPartialWord() {
+    int partial = _out._numBits & 63;
+    if (partial > 0) {
+        _acc = _out._words.back();
+        _accBits = partial;
+        _out._words.pop_back();
+        _out._numBits -= partial;
+    }
+}
+
+BitWriter::~BitWriter() {
+    flush();
+}
+
+/*
+ * The bits that fit go into the accumulator. When it fills up it becomes the next word
+ * and the bits that did not fit start the new accumulator.
+ */
+void BitWriter::write(uint64_t value, int count) {
+    if (count < 0 || count > 64) {
+        error("BitWriter: count must be between 0 and 64");
+    }
+    if (count == 0) {
+        return;
+    }
+    if (_accBits == 0 && (_out._numBits & 63) != 0) {
+        reclaimPartialWord();
+    }
+    if (count < 64) {
+        value &= (1ULL << count) - 1;
+    }
+    int free = 64 - _accBits;
+    if (count < free) {
+        _acc |= value << (free - count);
+        _accBits += count;
+    }
+    else {
+        int spill = count - free;
+        _acc |= value >> spill;
+        _out._words.push_back(_acc);
+        _out._numBits += 64;
+        _acc = (spill > 0) ? value << (64 - spill) : 0;
+        _accBits = spill;
+    }
+}
+
+void BitWriter::writeBit(int bit) {
+    write(bit, 1);
+}
+
+void BitWriter::write(const BitBuffer& bits) {
+    int64_t fullWords = bits._numBits >> 6;
+    for (int64_t i = 0; i < fullWords; i++) {
+        write(bits._words[i], 64);
+    }
+    int rest = bits._numBits & 63;
+    if (rest > 0) {
+        write(bits._words[fullWords] >> (64 - rest), rest);
+    }
+}
+
+/*
+ * Moves the pending bits into the buffer as a partial last word. A later write takes
+ * that word back out again.
+ */
+void BitWriter::flush() {
+    if (_accBits > 0) {
+        _out._words.push_back(_acc);
+        _out._numBits += _accBits;
+        _acc = 0;
+        _accBits = 0;
+    }
+}
+
+BitReader::BitReader(const BitBuffer& bits) {
+    _words = bits._words.data();
+    _numWords = bits._words.size();
+    _numBits = bits._numBits;
+    _pos = 0;
+}
+
+/*
+ * The next count bits start at bit (pos % 64) of word pos / 64 and may run into the
+ * following word. Shifting both words into place needs no loop.
+ */
+uint64_t BitReader::peek(int count) const {
+    if (count == 0) {
+        return 0;
+    }
+    int64_t word = _pos >> 6;
+    int offset = _pos & 63;
+    uint64_t bits = (word < _numWords) ? _words[word] << offset : 0;
+    if (offset > 0 && offset + count > 64 && word + 1 < _numWords) {
+        bits |= _words[word + 1] >> (64 - offset);
+    }
+    return bits >> (64 - count);
+}
+
+void BitReader::skip(int64_t count) {
+    _pos += count;
+}
+
+uint64_t BitReader::read(int count) {
+    if (count > remaining()) {
+        error("BitReader: not enough bits left");
+    }
+    uint64_t bits = peek(count);
+    _pos += count;
+    return bits;
+}
+
+int BitReader::readBit() {
+    return read(1);
+}
+
+int64_t BitReader::remaining() const {
+    return _numBits - _pos;
+}
+
+BitBuffer toBitBuffer(const Queue<Bit>& bits) {
+    BitBuffer result;
+    BitWriter writer(result);
+    Queue<Bit> copy = bits;
+    while (!copy.isEmpty()) {
+        writer.writeBit(copy.dequeue() == 1 ? 1 : 0);
+    }
+    writer.flush();
+    return result;
+}
+
+Queue<Bit> toBitQueue(const BitBuffer& bits) {
+    Queue<Bit> result;
+    for (int64_t i = 0; i < bits.size(); i++) {
+        result.enqueue(bits.get(i));
+    }
+    return result;
+}
+
+PackedEncodedData toPackedEncodedData(const EncodedData& data) {
+    PackedEncodedData result;
+    result.treeShape = toBitBuffer(data.treeShape);
+    Queue<char> leaves = data.treeLeaves;
+    while (!leaves.isEmpty()) {
+        result.treeLeaves += leaves.dequeue();
+    }
+    result.messageBits = toBitBuffer(data.messageBits);
+    return result;
+}
+
+EncodedData toEncodedData(const PackedEncodedData& data) {
+    EncodedData result;
+    result.treeShape = toBitQueue(data.treeShape);
+    for (char ch : data.treeLeaves) {
+        result.treeLeaves.enqueue(ch);
+    }
+    result.messageBits = toBitQueue(data.messageBits);
+    return result;
+}
+
+/*
+ * The tree is small, so it still goes through flattenTree and queues. The message, which
+ * is where the size is, is written straight into the BitBuffer by a HuffmanEncodeTable.
+ */
+PackedEncodedData compressPacked(const string& messageText) {
+    EncodingTreeNode* tree = buildHuffmanTree(messageText);
+    PackedEncodedData result;
+
+    Queue<Bit> treeShape;
+    Queue<char> treeLeaves;
+    flattenTree(tree, treeShape, treeLeaves);
+    result.treeShape = toBitBuffer(treeShape);
+    while (!treeLeaves.isEmpty()) {
+        result.treeLeaves += treeLeaves.dequeue();
+    }
+
+    HuffmanEncodeTable codes(tree);
+    codes.encode(messageText, result.messageBits);
+
+    deallocateTree(tree);
+    return result;
+}
+
+string decompressPacked(const PackedEncodedData& data) {
+    Queue<Bit> treeShape = toBitQueue(data.treeShape);
+    Queue<char> treeLeaves;
+    for (char ch : data.treeLeaves) {
+        treeLeaves.enqueue(ch);
+    }
+    EncodingTreeNode* tree = unflattenTree(treeShape, treeLeaves);
+    HuffmanDecodeTable table(tree);
+    BitReader reader(data.messageBits);
+    string message = table.decode(reader);
+    deallocateTree(tree);
+    return message;
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * */
+
+STUDENT_TEST("BitWriter / BitReader round trip with mixed widths, across flushes") {
+    BitBuffer buffer;
+    Vector<int> widths;
+    Vector<uint64_t> values;
+    {
+        BitWriter writer(buffer);
+        for (int i = 0; i < 2000; i++) {
+            int width = randomInteger(0, 64);
+            uint64_t value = ((uint64_t) randomInteger(0, 1 << 30) << 34) ^ (uint64_t) randomInteger(0, 1 << 30);
+            if (width < 64) {
+                value &= (1ULL << width) - 1;
+            }
+            widths.add(width);
+            values.add(value);
+            writer.write(value, width);
+            if (i % 97 == 0) {
+                writer.flush();
+            }
+        }
+    }
+    int64_t total = 0;
+    for (int width : widths) {
+        total += width;
+    }
+    EXPECT_EQUAL(buffer.size(), total);
+
+    BitReader reader(buffer);
+    for (int i = 0; i < widths.size(); i++) {
+        EXPECT_EQUAL(reader.peek(widths[i]), values[i]);
+        EXPECT_EQUAL(reader.read(widths[i]), values[i]);
+    }
+    EXPECT_EQUAL(reader.remaining(), 0);
+    EXPECT_EQUAL(reader.peek(7), 0ULL);
+    EXPECT_ERROR(reader.readBit());
+
+    // a second writer carries on from a partial last word
+    BitBuffer bits;
+    BitWriter(bits).write(0b101, 3);
+    BitWriter(bits).write(0b01, 2);
+    EXPECT_EQUAL(bits, toBitBuffer({ 1, 0, 1, 0, 1 }));
+    EXPECT_ERROR(BitWriter(bits).write(0, 65));
+}
+
+STUDENT_TEST("appendBytes / fromBytes round trip") {
+    for (int numBits : { 0, 1, 7, 8, 9, 63, 64, 65, 200 }) {
+        BitBuffer bits;
+        BitWriter writer(bits);
+        for (int i = 0; i < numBits; i++) {
+            writer.writeBit(randomInteger(0, 1));
+        }
+        writer.flush();
+        string bytes;
+        bits.appendBytes(bytes);
+        EXPECT_EQUAL(bytes.size(), (size_t) (numBits + 7) / 8);
+        EXPECT_EQUAL(BitBuffer::fromBytes(bytes.data(), numBits), bits);
+    }
+    string bytes = "\xA5\xFF";
+    EXPECT_EQUAL(BitBuffer::fromBytes(bytes.data(), 9), toBitBuffer({ 1, 0, 1, 0, 0, 1, 0, 1, 1 }));
+}
+
+STUDENT_TEST("Queue<Bit> adapters round trip, and match compress()") {
+    Queue<Bit> bits = { 1, 1, 0, 1, 0, 0, 0, 1, 1 };
+    BitBuffer buffer = toBitBuffer(bits);
+    EXPECT_EQUAL(buffer.size(), 9);
+    EXPECT_EQUAL(buffer.get(0), 1);
+    EXPECT_EQUAL(buffer.get(8), 1);
+    EXPECT_ERROR(buffer.get(9));
+    EXPECT_EQUAL(toBitQueue(buffer), bits);
+    EXPECT_EQUAL(toBitQueue(BitBuffer()), Queue<Bit>());
+
+    string text = "happy hip hop";
+    EncodedData data = compress(text);
+    PackedEncodedData packed = compressPacked(text);
+    EncodedData unpacked = toEncodedData(packed);
+    EXPECT_EQUAL(unpacked.treeShape, data.treeShape);
+    EXPECT_EQUAL(unpacked.treeLeaves, data.treeLeaves);
+    EXPECT_EQUAL(unpacked.messageBits, data.messageBits);
+    EXPECT(toPackedEncodedData(data).messageBits == packed.messageBits);
+    EXPECT_EQUAL(decompressPacked(toPackedEncodedData(data)), text);
+    EXPECT_EQUAL(decompress(unpacked), text);
+}
+
+STUDENT_TEST("compressPacked -> decompressPacked end to end") {
+    for (string file : { "res/constitution.txt", "res/dream.txt" }) {
+        string text = readEntireFile(file);
+        PackedEncodedData packed = compressPacked(text);
+        EXPECT_EQUAL(decompressPacked(packed), text);
+    }
+    EXPECT_ERROR(compressPacked("aaaa"));
+}
+
+STUDENT_TEST("compress/decompress vs compressPacked/decompressPacked: time trial and memory") {
+    string base = readEntireFile("res/constitution.txt");
+    for (int copies = 4; copies <= 16; copies *= 2) {
+        string text;
+        for (int i = 0; i < copies; i++) {
+            text += base;
+        }
+        EncodedData data;
+        PackedEncodedData packed;
+        string fromQueue, fromPacked;
+        TIME_OPERATION(text.size(), data = compress(text));
+        TIME_OPERATION(text.size(), packed = compressPacked(text));
+        EXPECT(packed.messageBits.bytesUsed() < (int64_t) (data.messageBits.size() * sizeof(Bit)));
+        TIME_OPERATION(text.size(), fromQueue = decompress(data));
+        TIME_OPERATION(text.size(), fromPacked = decompressPacked(packed));
+        EXPECT_EQUAL(fromQueue, text);
+        EXPECT_EQUAL(fromPacked, text);
+    }
+}
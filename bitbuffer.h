@@ -0,0 +1,215 @@
+/* File: bitbuffer.h
+ * Assignment brief: packed bit buffer for encoded Huffman data. Queue<Bit> spends a whole
+ * queue element on every bit; BitBuffer keeps 64 bits in each word, first bit in the high
+ * bit of the first word. BitWriter appends through a 64-bit accumulator and BitReader
+ * reads any number of bits (up to 64) at a time.
+ */
+#pragma once
+#include "bits.h"
+#include "huffman.h"
+#include "queue.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * A growable sequence of bits stored in 64-bit words.
+ */
+class BitBuffer {
+public:
+    /**
+     * Creates an empty buffer.
+     */
+    BitBuffer();
+
+    /**
+     * Returns the number of bits in the buffer.
+     */
+    int64_t size() const;
+
+    bool isEmpty() const;
+
+    /**
+     * Returns bit index (0 or 1).
+     *
+     * Reports an error if index is out of range.
+     */
+    int get(int64_t index) const;
+
+    /**
+     * Removes every bit.
+     */
+    void clear();
+
+    /**
+     * Returns the number of bytes of word storage in use, for comparing against Queue<Bit>.
+     */
+    int64_t bytesUsed() const;
+
+    /**
+     * Returns the words that hold the bits, first bit in the high bit of the first word.
+     * Bits past size() in the last word are always 0.
+     */
+    const std::vector<uint64_t>& words() const;
+
+    /**
+     * Appends the bits to out packed 8 to a byte, first bit in the high bit of the first
+     * byte, with the last byte padded with 0s. Since the words hold their first bit in the
+     * high bit too, this is each word's bytes in big-endian order.
+     */
+    void appendBytes(std::string& out) const;
+
+    /**
+     * Inverse of appendBytes: returns the first numBits bits packed in data.
+     */
+    static BitBuffer fromBytes(const char* data, int64_t numBits);
+
+    bool operator==(const BitBuffer& other) const;
+    bool operator!=(const BitBuffer& other) const;
+
+private:
+    std::vector<uint64_t> _words;   // bits past _numBits in the last word are always 0
+    int64_t _numBits;
+
+    friend class BitWriter;
+    friend class BitReader;
+    friend class HuffmanEncodeTable;
+};
+
+std::ostream& operator<<(std::ostream& out, const BitBuffer& bits);
+
+/**
+ * Appends bits to the end of a BitBuffer. Bits are collected in a 64-bit accumulator and
+ * stored a word at a time, so the buffer is only up to date after flush() (which the
+ * destructor also calls). Writing may continue after a flush.
+ */
+class BitWriter {
+public:
+    /**
+     * Creates a writer that appends to out.
+     */
+    BitWriter(BitBuffer& out);
+
+    /**
+     * Calls flush().
+     */
+    ~BitWriter();
+
+    /**
+     * Appends the low count bits of value, highest of them first.
+     *
+     * Reports an error if count is not between 0 and 64.
+     */
+    void write(uint64_t value, int count);
+
+    /**
+     * Appends one bit.
+     */
+    void writeBit(int bit);
+
+    /**
+     * Appends every bit of bits.
+     */
+    void write(const BitBuffer& bits);
+
+    /**
+     * Stores any bits still in the accumulator in the buffer.
+     */
+    void flush();
+
+private:
+    BitBuffer& _out;
+    uint64_t _acc;      // pending bits, left-aligned
+    int _accBits;       // number of pending bits
+
+    void reclaimPartialWord();
+};
+
+/**
+ * Reads bits from the front of a BitBuffer without changing it. The buffer must not be
+ * modified while the reader is in use.
+ */
+class BitReader {
+public:
+    /**
+     * Creates a reader positioned at the first bit of bits.
+     */
+    BitReader(const BitBuffer& bits);
+
+    /**
+     * Returns the next count bits as an integer (the first of them in the highest place)
+     * without consuming them. Bits past the end of the buffer read as 0.
+     *
+     * count must be between 0 and 64.
+     */
+    uint64_t peek(int count) const;
+
+    /**
+     * Consumes count bits.
+     */
+    void skip(int64_t count);
+
+    /**
+     * Returns and consumes the next count bits.
+     *
+     * Reports an error if fewer than count bits are left.
+     */
+    uint64_t read(int count);
+
+    /**
+     * Returns and consumes the next bit.
+     *
+     * Reports an error if there are no bits left.
+     */
+    int readBit();
+
+    /**
+     * Returns the number of bits not yet consumed. Negative if skip() went past the end.
+     */
+    int64_t remaining() const;
+
+private:
+    const uint64_t* _words;
+    int64_t _numWords;
+    int64_t _numBits;
+    int64_t _pos;
+};
+
+/**
+ * Packs the bits of a Queue<Bit> into a BitBuffer. The queue is not changed.
+ */
+BitBuffer toBitBuffer(const Queue<Bit>& bits);
+
+/**
+ * Unpacks a BitBuffer into a Queue<Bit>.
+ */
+Queue<Bit> toBitQueue(const BitBuffer& bits);
+
+/**
+ * Packed counterpart of EncodedData: the same three parts, with the bits in BitBuffers.
+ */
+struct PackedEncodedData {
+    BitBuffer treeShape;
+    std::string treeLeaves;
+    BitBuffer messageBits;
+};
+
+/**
+ * Converts between EncodedData and PackedEncodedData. The input is not changed.
+ */
+PackedEncodedData toPackedEncodedData(const EncodedData& data);
+EncodedData toEncodedData(const PackedEncodedData& data);
+
+/**
+ * Same as compress, but the message bits are written straight into a BitBuffer and never
+ * go through a Queue<Bit>.
+ *
+ * Reports an error if the message text does not contain at least two distinct characters.
+ */
+PackedEncodedData compressPacked(const std::string& messageText);
+
+/**
+ * Same as decompress, reading the message bits from the BitBuffer with a table-driven
+ * decoder (see huffmantable.h). data is not changed.
+ */
+std::string decompressPacked(const PackedEncodedData& data);
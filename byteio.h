@@ -0,0 +1,89 @@
+/* File: byteio.h
+ * Assignment brief: small helpers for reading and writing integers in the binary formats
+ * (dpbinary, dparchive, ...). Fixed-width integers are little-endian; varints are
+ * base-128 with the low 7 bits first.
+ */
+#pragma once
+#include "error.h"
+#include <cstdint>
+#include <string>
+
+/**
+ * Appends value to out as 4 little-endian bytes.
+ */
+inline void appendU32(std::string& out, uint32_t value) {
+    out += (char) (value & 0xFF);
+    out += (char) ((value >> 8) & 0xFF);
+    out += (char) ((value >> 16) & 0xFF);
+    out += (char) ((value >> 24) & 0xFF);
+}
+
+/**
+ * Reads 4 little-endian bytes starting at data[pos]. The caller checks the bounds.
+ */
+inline uint32_t readU32(const char* data, size_t pos) {
+    const unsigned char* bytes = (const unsigned char*) data + pos;
+    return (uint32_t) bytes[0] | ((uint32_t) bytes[1] << 8) |
+           ((uint32_t) bytes[2] << 16) | ((uint32_t) bytes[3] << 24);
+}
+
+/**
+ * Appends value to out as 8 little-endian bytes.
+ */
+inline void appendU64(std::string& out, uint64_t value) {
+    appendU32(out, (uint32_t) value);
+    appendU32(out, (uint32_t) (value >> 32));
+}
+
+/**
+ * Reads 8 little-endian bytes starting at data[pos]. The caller checks the bounds.
+ */
+inline uint64_t readU64(const char* data, size_t pos) {
+    return (uint64_t) readU32(data, pos) | ((uint64_t) readU32(data, pos + 4) << 32);
+}
+
+/**
+ * Appends value to out as a varint: 7 bits per byte, high bit set on every byte but the last.
+ */
+inline void appendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += (char) ((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += (char) value;
+}
+
+/**
+ * Reads a varint from data starting at pos, and moves pos past it.
+ *
+ * Reports an error if the varint runs past size or is longer than 10 bytes.
+ */
+inline uint64_t readVarint(const char* data, size_t size, size_t& pos) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 70; shift += 7) {
+        if (pos >= size) {
+            error("readVarint: truncated varint");
+        }
+        unsigned char byte = data[pos++];
+        value |= (uint64_t) (byte & 0x7F) << shift;
+        if (byte < 0x80) {
+            return value;
+        }
+    }
+    error("readVarint: varint too long");
+}
+
+/**
+ * Maps signed values to unsigned so that numbers near zero (of either sign) stay small:
+ * 0, -1, 1, -2, 2, ... become 0, 1, 2, 3, 4, ...
+ */
+inline uint64_t zigzagEncode(int64_t value) {
+    return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+/**
+ * Inverse of zigzagEncode.
+ */
+inline int64_t zigzagDecode(uint64_t value) {
+    return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+}
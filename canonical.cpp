@@ -0,0 +1,1080 @@
+/* File: canonical.cpp
+ * Assignment brief: canonical Huffman codes with code-length-only headers. The header file,
+ * "canonical.h" is in this repository.
+ */
+#include "canonical.h"
+#include "huffman.h"
+#include "huffmanbuild.h"
+#include "huffmanencode.h"
+#include "byteio.h"
+#include "error.h"
+#include "filelib.h"
+#include "random.h"
+#include "strlib.h"
+#include <algorithm>
+#include <vector>
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/*
+ * Children always have lower node numbers than their parent in buildHuffmanNodes, so one
+ * pass down from the root gives every depth.
+ */
+void codeLengthsFromCounts(const int64_t counts[256], uint8_t lengths[256]) {
+    HuffmanNodes nodes;
+    buildHuffmanNodes(counts, nodes);
+    for (int b = 0; b < 256; b++) {
+        lengths[b] = 0;
+    }
+    if (nodes.numLeaves == 0) {
+        return;
+    }
+    if (nodes.numLeaves == 1) {
+        lengths[nodes.symbol[0]] = 1;
+        return;
+    }
+
+    int depth[511];
+    depth[nodes.numNodes - 1] = 0;
+    for (int node = nodes.numNodes - 1; node >= nodes.numLeaves; node--) {
+        depth[nodes.zero[node]] = depth[node] + 1;
+        depth[nodes.one[node]] = depth[node] + 1;
+    }
+    for (int leaf = 0; leaf < nodes.numLeaves; leaf++) {
+        if (depth[leaf] > kMaxCodeLength) {
+            error("codeLengthsFromCounts: code longer than kMaxCodeLength");
+        }
+        lengths[nodes.symbol[leaf]] = depth[leaf];
+    }
+}
+
+/*
+ * Package-merge (Larmore and Hirschberg). The first list holds the used byte values in
+ * order of count. Each later list is the byte values merged, in order of weight, with
+ * packages of neighboring pairs of the list before it, weighing their sum. After maxLength
+ * lists, the 2n - 2 lightest items of the last one are the best choice, and each byte
+ * value's code length is how many times it appears inside them.
+ *
+ * What is taken from every list is a prefix: some of its lightest byte values, and
+ * packages made of a prefix of the list before. No list needs more than 2n - 2 items, so
+ * the rest are never made, and only which places in each list hold byte values is kept.
+ * The lengths are then counted walking back from the last list.
+ */
+void limitedCodeLengthsFromCounts(const int64_t counts[256], int maxLength, uint8_t lengths[256]) {
+    if (maxLength < 1 || maxLength > kMaxCodeLength) {
+        error("limitedCodeLengthsFromCounts: maxLength must be between 1 and kMaxCodeLength");
+    }
+    int symbols[256];
+    int n = 0;
+    for (int b = 0; b < 256; b++) {
+        if (counts[b] > 0) {
+            symbols[n++] = b;
+        }
+    }
+    if (maxLength < 8 && n > (1 << maxLength)) {
+        error("limitedCodeLengthsFromCounts: maxLength is too short for this many byte values");
+    }
+    codeLengthsFromCounts(counts, lengths);
+    int longest = *max_element(lengths, lengths + 256);
+    if (longest <= maxLength) {
+        return;
+    }
+
+    stable_sort(symbols, symbols + n, [&](int a, int b) { return counts[a] < counts[b]; });
+    int width = 2 * n - 2;                  // longest any list gets
+    vector<uint8_t> isLeaf(maxLength * width);
+    int64_t leafWeight[257];
+    for (int i = 0; i < n; i++) {
+        leafWeight[i] = counts[symbols[i]];
+        isLeaf[i] = 1;
+    }
+    leafWeight[n] = INT64_MAX;
+    int64_t lists[2][512];                  // weights of the list before and the one being made
+    copy(leafWeight, leafWeight + n, lists[0]);
+    int size = n;
+    for (int level = 1; level < maxLength; level++) {
+        const int64_t* before = lists[(level - 1) & 1];
+        int64_t* merged = lists[level & 1];
+        uint8_t* leafFlags = &isLeaf[level * width];
+        int numPairs = size / 2;
+        size = min(n + numPairs, width);
+        int leaf = 0;
+        int pair = 0;
+        for (int k = 0; k < size; k++) {
+            // written without branches: which one is lighter is too random to predict
+            int64_t packageWeight = (pair < numPairs) ? before[2 * pair] + before[2 * pair + 1] : INT64_MAX;
+            bool takeLeaf = leafWeight[leaf] <= packageWeight;
+            merged[k] = takeLeaf ? leafWeight[leaf] : packageWeight;
+            leafFlags[k] = takeLeaf;
+            leaf += takeLeaf;
+            pair += !takeLeaf;
+        }
+    }
+
+    for (int b = 0; b < 256; b++) {
+        lengths[b] = 0;
+    }
+    int take = width;
+    for (int level = maxLength - 1; level >= 0 && take > 0; level--) {
+        int leavesTaken = 0;
+        for (int i = 0; i < take; i++) {
+            leavesTaken += isLeaf[level * width + i];
+        }
+        for (int i = 0; i < leavesTaken; i++) {
+            lengths[symbols[i]]++;
+        }
+        take = 2 * (take - leavesTaken);
+    }
+}
+
+/* HELPER FUNCTION: records the depth of every leaf below node. */
+static void recordDepths(EncodingTreeNode* node, int depth, uint8_t lengths[256]) {
+    if (node->isLeaf()) {
+        if (depth > kMaxCodeLength) {
+            error("codeLengthsFromTree: tree deeper than kMaxCodeLength");
+        }
+        lengths[(unsigned char) node->ch] = depth;
+    }
+    else {
+        recordDepths(node->zero, depth + 1, lengths);
+        recordDepths(node->one, depth + 1, lengths);
+    }
+}
+
+void codeLengthsFromTree(EncodingTreeNode* tree, uint8_t lengths[256]) {
+    for (int b = 0; b < 256; b++) {
+        lengths[b] = 0;
+    }
+    recordDepths(tree, 0, lengths);
+}
+
+/*
+ * Same numbering as DEFLATE (RFC 1951, section 3.2.2): the first code of each length is
+ * one past the last code of the previous length, shifted left one place. The codes of a
+ * length only fit if there is room for all of them below 2^length.
+ */
+void canonicalCodes(const uint8_t lengths[256], uint64_t codes[256]) {
+    int count[kMaxCodeLength + 1] = { 0 };
+    for (int b = 0; b < 256; b++) {
+        if (lengths[b] > kMaxCodeLength) {
+            error("canonicalCodes: length longer than kMaxCodeLength");
+        }
+        count[lengths[b]]++;
+    }
+    count[0] = 0;
+
+    uint64_t next[kMaxCodeLength + 1];
+    uint64_t code = 0;
+    for (int length = 1; length <= kMaxCodeLength; length++) {
+        code = (code + count[length - 1]) << 1;
+        next[length] = code;
+        if (code + count[length] > (1ULL << length)) {
+            error("canonicalCodes: lengths do not describe a prefix code");
+        }
+        if (count[length] > 0 && code + count[length] == (1ULL << length)) {
+            // the code space is full, so no longer code may follow
+            for (int longer = length + 1; longer <= kMaxCodeLength; longer++) {
+                if (count[longer] > 0) {
+                    error("canonicalCodes: lengths do not describe a prefix code");
+                }
+            }
+            break;
+        }
+    }
+
+    for (int b = 0; b < 256; b++) {
+        if (lengths[b] > 0) {
+            codes[b] = next[lengths[b]]++;
+        }
+    }
+}
+
+/* HELPER FUNCTION: appends count values of width bits each, packed MSB first into bytes. */
+static void packFields(string& out, const Vector<int>& values, int width) {
+    int acc = 0;
+    int filled = 0;
+    for (int value : values) {
+        for (int bit = width - 1; bit >= 0; bit--) {
+            acc = (acc << 1) | ((value >> bit) & 1);
+            filled++;
+            if (filled == 8) {
+                out += (char) acc;
+                acc = 0;
+                filled = 0;
+            }
+        }
+    }
+    if (filled > 0) {
+        out += (char) (acc << (8 - filled));
+    }
+}
+
+string packCodeLengths(const uint8_t lengths[256]) {
+    Vector<int> used;
+    Vector<int> usedLengths;
+    int maxLength = 0;
+    for (int b = 0; b < 256; b++) {
+        if (lengths[b] > 0) {
+            used.add(b);
+            usedLengths.add(lengths[b]);
+            maxLength = max(maxLength, (int) lengths[b]);
+        }
+    }
+    int width = (maxLength <= 15) ? 4 : 7;
+    bool bitmap = 1 + used.size() > 32;
+
+    string out;
+    out += (char) ((bitmap ? 0x80 : 0) | width);
+    if (bitmap) {
+        string bits(32, '\0');
+        for (int b : used) {
+            bits[b / 8] |= (char) (1 << (b % 8));
+        }
+        out += bits;
+    }
+    else {
+        out += (char) used.size();
+        for (int b : used) {
+            out += (char) b;
+        }
+    }
+    packFields(out, usedLengths, width);
+    return out;
+}
+
+void unpackCodeLengths(const string& bytes, size_t& pos, uint8_t lengths[256]) {
+    if (pos >= bytes.size()) {
+        error("unpackCodeLengths: truncated header");
+    }
+    int format = (unsigned char) bytes[pos++];
+    int width = format & 0x7F;
+    if (width != 4 && width != 7) {
+        error("unpackCodeLengths: bad length width");
+    }
+
+    Vector<int> used;
+    if (format & 0x80) {
+        if (bytes.size() - pos < 32) {
+            error("unpackCodeLengths: truncated header");
+        }
+        for (int b = 0; b < 256; b++) {
+            if ((bytes[pos + b / 8] >> (b % 8)) & 1) {
+                used.add(b);
+            }
+        }
+        pos += 32;
+    }
+    else {
+        if (pos >= bytes.size()) {
+            error("unpackCodeLengths: truncated header");
+        }
+        int count = (unsigned char) bytes[pos++];
+        if (bytes.size() - pos < (size_t) count) {
+            error("unpackCodeLengths: truncated header");
+        }
+        for (int i = 0; i < count; i++) {
+            int b = (unsigned char) bytes[pos++];
+            if (!used.isEmpty() && b <= used[used.size() - 1]) {
+                error("unpackCodeLengths: used values out of order");
+            }
+            used.add(b);
+        }
+    }
+
+    size_t fieldBytes = (used.size() * width + 7) / 8;
+    if (bytes.size() - pos < fieldBytes) {
+        error("unpackCodeLengths: truncated header");
+    }
+    for (int b = 0; b < 256; b++) {
+        lengths[b] = 0;
+    }
+    for (int i = 0; i < used.size(); i++) {
+        int length = 0;
+        for (int bit = i * width; bit < (i + 1) * width; bit++) {
+            length = (length << 1) | ((bytes[pos + bit / 8] >> (7 - bit % 8)) & 1);
+        }
+        if (length == 0 || length > kMaxCodeLength) {
+            error("unpackCodeLengths: bad code length");
+        }
+        lengths[used[i]] = length;
+    }
+    pos += fieldBytes;
+}
+
+CanonicalDecoder::CanonicalDecoder(const uint8_t lengths[256], int tableBits) {
+    if (tableBits < 1 || tableBits > 16) {
+        error("CanonicalDecoder: tableBits must be between 1 and 16");
+    }
+    uint64_t codes[256];
+    canonicalCodes(lengths, codes);
+
+    _tableBits = tableBits;
+    _maxLength = 0;
+    for (int length = 0; length <= kMaxCodeLength; length++) {
+        _count[length] = 0;
+    }
+    for (int b = 0; b < 256; b++) {
+        _count[lengths[b]]++;
+    }
+    int next[kMaxCodeLength + 1];
+    int index = 0;
+    for (int length = 1; length <= kMaxCodeLength; length++) {
+        _firstIndex[length] = index;
+        next[length] = index;
+        index += _count[length];
+        if (_count[length] > 0) {
+            _maxLength = length;
+        }
+    }
+    for (int b = 0; b < 256; b++) {
+        if (lengths[b] > 0) {
+            _symbols[next[lengths[b]]++] = b;
+        }
+    }
+    for (int length = 1; length <= kMaxCodeLength; length++) {
+        _firstCode[length] = (_count[length] > 0) ? codes[_symbols[_firstIndex[length]]] : 0;
+    }
+
+    _entries = new Entry[1 << tableBits];
+    for (int i = 0; i < (1 << tableBits); i++) {
+        _entries[i] = { 0, 0 };
+    }
+    for (int b = 0; b < 256; b++) {
+        if (lengths[b] > 0 && lengths[b] <= tableBits) {
+            int span = tableBits - lengths[b];
+            uint32_t start = codes[b] << span;
+            for (uint32_t i = 0; i < (1u << span); i++) {
+                _entries[start + i] = { (uint8_t) b, lengths[b] };
+            }
+        }
+    }
+}
+
+CanonicalDecoder::~CanonicalDecoder() {
+    delete[] _entries;
+}
+
+/* HELPER FUNCTION: finds a code longer than tableBits. Canonical codes of one length are
+ * numerically above every prefix of a longer code, so trying lengths from short to long
+ * finds the right one. Consumes the code and returns its symbol.
+ */
+int CanonicalDecoder::decodeLong(BitReader& bits) const {
+    for (int length = _tableBits + 1; length <= _maxLength; length++) {
+        uint64_t offset = bits.peek(length) - _firstCode[length];
+        if (offset < (uint64_t) _count[length]) {
+            bits.skip(length);
+            return _symbols[_firstIndex[length] + offset];
+        }
+    }
+    error("CanonicalDecoder: bits do not form a code");
+    return 0;
+}
+
+string CanonicalDecoder::decode(BitReader& bits) const {
+    string msg;
+    while (bits.remaining() > 0) {
+        const Entry& entry = _entries[bits.peek(_tableBits)];
+        if (entry.length > 0) {
+            bits.skip(entry.length);
+            msg += (char) entry.symbol;
+        }
+        else {
+            msg += (char) decodeLong(bits);
+        }
+        if (bits.remaining() < 0) {
+            error("CanonicalDecoder: message bits end in the middle of a code");
+        }
+    }
+    return msg;
+}
+
+void CanonicalDecoder::decode(BitReader& bits, char* out, int64_t count) const {
+    for (int64_t i = 0; i < count; i++) {
+        const Entry& entry = _entries[bits.peek(_tableBits)];
+        if (entry.length > 0) {
+            bits.skip(entry.length);
+            out[i] = entry.symbol;
+        }
+        else {
+            out[i] = decodeLong(bits);
+        }
+    }
+    if (bits.remaining() < 0) {
+        error("CanonicalDecoder: message bits end in the middle of a code");
+    }
+}
+
+/*
+ * The streams' words are read in place. While a stream's position is before its last word,
+ * its next 64 bits can be read as two whole words with no bounds checks; positions are bit
+ * offsets into each stream. The inner loop only handles steps where every stream is in
+ * that range and its next code is in the table; it keeps each position in its own local so
+ * the four lookup chains stay in registers and run side by side. Any other step leaves the
+ * loop and is done the slow way, one stream at a time, reading past the end as zeros.
+ */
+string CanonicalDecoder::decodeInterleaved(const BitBuffer streams[], int numStreams, int64_t length) const {
+    if (numStreams != 1 && numStreams != kInterleavedStreams) {
+        error("CanonicalDecoder: numStreams must be 1 or kInterleavedStreams");
+    }
+    const uint64_t* base[kInterleavedStreams];
+    int64_t numWords[kInterleavedStreams];
+    int64_t limit[kInterleavedStreams];
+    int64_t end[kInterleavedStreams];
+    int64_t pos[kInterleavedStreams];
+    for (int k = 0; k < numStreams; k++) {
+        base[k] = streams[k].words().data();
+        numWords[k] = streams[k].words().size();
+        limit[k] = (numWords[k] - 1) * 64;
+        end[k] = streams[k].size();
+        pos[k] = 0;
+    }
+    const Entry* entries = _entries;
+    const int shift = 64 - _tableBits;
+
+    auto peek = [&](const uint64_t* words, int64_t p) -> Entry {
+        uint64_t window = words[p >> 6] << (p & 63);
+        window |= (words[(p >> 6) + 1] >> 1) >> (63 - (p & 63));
+        return entries[window >> shift];
+    };
+    auto wordAt = [&](int k, int64_t w) -> uint64_t {
+        return (w < numWords[k]) ? base[k][w] : 0;
+    };
+    // Decodes the next character of stream k, including codes longer than the table.
+    auto decodeOne = [&](int k) -> char {
+        int64_t p = pos[k];
+        uint64_t window = wordAt(k, p >> 6) << (p & 63);
+        window |= (wordAt(k, (p >> 6) + 1) >> 1) >> (63 - (p & 63));
+        Entry entry = entries[window >> shift];
+        if (entry.length > 0) {
+            pos[k] += entry.length;
+            return entry.symbol;
+        }
+        BitReader reader(streams[k]);
+        reader.skip(pos[k]);
+        char symbol = decodeLong(reader);
+        pos[k] = end[k] - reader.remaining();
+        return symbol;
+    };
+    auto checkOverrun = [&]() {
+        for (int k = 0; k < numStreams; k++) {
+            if (pos[k] > end[k]) {
+                error("CanonicalDecoder: message bits end in the middle of a code");
+            }
+        }
+    };
+
+    string msg(length, '\0');
+    char* out = &msg[0];
+    int64_t steps = length / numStreams;
+    for (int64_t step = 0; step < steps; ) {
+        if (numStreams == 1) {
+            const uint64_t* words = base[0];
+            int64_t p = pos[0];
+            int64_t l = limit[0];
+            for (; step < steps && p < l; step++) {
+                Entry entry = peek(words, p);
+                if (entry.length == 0) {
+                    break;
+                }
+                p += entry.length;
+                out[step] = entry.symbol;
+            }
+            pos[0] = p;
+        }
+        else {
+            int64_t p0 = pos[0], p1 = pos[1], p2 = pos[2], p3 = pos[3];
+            for (; step < steps; step++) {
+                if ((p0 >= limit[0]) | (p1 >= limit[1]) | (p2 >= limit[2]) | (p3 >= limit[3])) {
+                    break;
+                }
+                Entry a = peek(base[0], p0), b = peek(base[1], p1);
+                Entry c = peek(base[2], p2), d = peek(base[3], p3);
+                if ((a.length == 0) | (b.length == 0) | (c.length == 0) | (d.length == 0)) {
+                    break;
+                }
+                p0 += a.length;
+                p1 += b.length;
+                p2 += c.length;
+                p3 += d.length;
+                out[4 * step] = a.symbol;
+                out[4 * step + 1] = b.symbol;
+                out[4 * step + 2] = c.symbol;
+                out[4 * step + 3] = d.symbol;
+            }
+            pos[0] = p0;
+            pos[1] = p1;
+            pos[2] = p2;
+            pos[3] = p3;
+        }
+        checkOverrun();
+        if (step < steps) {
+            for (int k = 0; k < numStreams; k++) {
+                out[step * numStreams + k] = decodeOne(k);
+            }
+            checkOverrun();
+            step++;
+        }
+    }
+    for (int k = 0; k < length % numStreams; k++) {
+        out[steps * numStreams + k] = decodeOne(k);
+    }
+    checkOverrun();
+    for (int k = 0; k < numStreams; k++) {
+        if (pos[k] != end[k]) {
+            error("CanonicalDecoder: stream length does not match its codes");
+        }
+    }
+    return msg;
+}
+
+/*
+ * Every code is at most kMaxCodeLength bits, so the message is written by a
+ * HuffmanEncodeTable with no long-code fallback.
+ */
+CanonicalEncodedData compressCanonical(const string& messageText, int maxLength) {
+    int64_t counts[256];
+    countBytes(messageText, counts);
+    uint8_t lengths[256];
+    limitedCodeLengthsFromCounts(counts, maxLength, lengths);
+
+    CanonicalEncodedData result;
+    result.codeLengths = packCodeLengths(lengths);
+    HuffmanEncodeTable codes(lengths);
+    codes.encode(messageText, result.messageBits);
+    return result;
+}
+
+string serializeCanonical(const CanonicalEncodedData& data) {
+    string out = data.codeLengths;
+    appendVarint(out, data.messageBits.size());
+    data.messageBits.appendBytes(out);
+    return out;
+}
+
+/*
+ * Largest code-length header: format byte, 32-byte bitmap, 256 lengths of 7 bits. Then a
+ * varint of at most 10 bytes, and every character with a code of kMaxCodeLength bits.
+ */
+uint64_t maxSerializedCanonicalSize(uint64_t messageLength) {
+    return (1 + 32 + 224) + 10 + (messageLength * kMaxCodeLength + 7) / 8;
+}
+
+/*
+ * The code-length header is self-delimiting, so it is parsed once here to find where it
+ * ends and kept as bytes.
+ */
+CanonicalEncodedData deserializeCanonical(const string& bytes) {
+    uint8_t lengths[256];
+    size_t pos = 0;
+    unpackCodeLengths(bytes, pos, lengths);
+    CanonicalEncodedData data;
+    data.codeLengths = bytes.substr(0, pos);
+    uint64_t numBits = readVarint(bytes.data(), bytes.size(), pos);
+    if ((numBits + 7) / 8 != bytes.size() - pos) {
+        error("deserializeCanonical: message length does not match");
+    }
+    data.messageBits = BitBuffer::fromBytes(bytes.data() + pos, numBits);
+    return data;
+}
+
+/* HELPER FUNCTION: table width for decoding these lengths. Codes limited to
+ * kDefaultCodeLengthLimit bits all fit in the table; longer ones take the slow path.
+ */
+static int decodeTableBits(const uint8_t lengths[256]) {
+    int longest = *max_element(lengths, lengths + 256);
+    return max(1, min(longest, kDefaultCodeLengthLimit));
+}
+
+string decompressCanonical(const CanonicalEncodedData& data) {
+    uint8_t lengths[256];
+    size_t pos = 0;
+    unpackCodeLengths(data.codeLengths, pos, lengths);
+    if (pos != data.codeLengths.size()) {
+        error("decompressCanonical: extra bytes after the code lengths");
+    }
+    CanonicalDecoder decoder(lengths, decodeTableBits(lengths));
+    BitReader reader(data.messageBits);
+    return decoder.decode(reader);
+}
+
+/*
+ * The message is gathered into one string per stream first, so each stream is encoded
+ * by a single HuffmanEncodeTable::encode call.
+ */
+string compressInterleaved(const string& messageText, int maxLength) {
+    int64_t counts[256];
+    countBytes(messageText, counts);
+    uint8_t lengths[256];
+    limitedCodeLengthsFromCounts(counts, maxLength, lengths);
+    HuffmanEncodeTable codes(lengths);
+
+    size_t n = messageText.size();
+    string parts[kInterleavedStreams];
+    for (int k = 0; k < kInterleavedStreams; k++) {
+        parts[k].resize((n + kInterleavedStreams - 1 - k) / kInterleavedStreams);
+    }
+    for (size_t i = 0; i < n; i++) {
+        parts[i % kInterleavedStreams][i / kInterleavedStreams] = messageText[i];
+    }
+    BitBuffer streams[kInterleavedStreams];
+    for (int k = 0; k < kInterleavedStreams; k++) {
+        codes.encode(parts[k], streams[k]);
+    }
+
+    string out = packCodeLengths(lengths);
+    appendVarint(out, messageText.size());
+    for (int k = 0; k < kInterleavedStreams; k++) {
+        appendVarint(out, streams[k].size());
+    }
+    for (int k = 0; k < kInterleavedStreams; k++) {
+        streams[k].appendBytes(out);
+    }
+    return out;
+}
+
+/* Every stream can end in a partial byte, and has one more varint than serializeCanonical. */
+uint64_t maxInterleavedSize(uint64_t messageLength) {
+    return maxSerializedCanonicalSize(messageLength) + 10 * kInterleavedStreams + kInterleavedStreams;
+}
+
+/*
+ * Every code is at least one bit, so a message length bigger than the total bit count is
+ * rejected before the output is allocated.
+ */
+string decompressInterleaved(const string& bytes) {
+    uint8_t lengths[256];
+    size_t pos = 0;
+    unpackCodeLengths(bytes, pos, lengths);
+    uint64_t length = readVarint(bytes.data(), bytes.size(), pos);
+    uint64_t numBits[kInterleavedStreams];
+    uint64_t totalBits = 0;
+    for (int k = 0; k < kInterleavedStreams; k++) {
+        numBits[k] = readVarint(bytes.data(), bytes.size(), pos);
+        if (numBits[k] > (uint64_t) bytes.size() * 8) {
+            error("decompressInterleaved: stream is longer than the input");
+        }
+        totalBits += numBits[k];
+    }
+    if (length > totalBits) {
+        error("decompressInterleaved: message is longer than its bits allow");
+    }
+    BitBuffer streams[kInterleavedStreams];
+    for (int k = 0; k < kInterleavedStreams; k++) {
+        uint64_t numBytes = (numBits[k] + 7) / 8;
+        if (numBytes > bytes.size() - pos) {
+            error("decompressInterleaved: truncated stream");
+        }
+        streams[k] = BitBuffer::fromBytes(bytes.data() + pos, numBits[k]);
+        pos += numBytes;
+    }
+    if (pos != bytes.size()) {
+        error("decompressInterleaved: extra bytes after the streams");
+    }
+    CanonicalDecoder decoder(lengths, decodeTableBits(lengths));
+    return decoder.decodeInterleaved(streams, kInterleavedStreams, length);
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * */
+
+STUDENT_TEST("canonicalCodes: the DEFLATE example, and lengths that aren't a prefix code") {
+    // RFC 1951: A-H with lengths (3, 3, 3, 3, 3, 2, 4, 4)
+    uint8_t lengths[256] = { 0 };
+    int example[8] = { 3, 3, 3, 3, 3, 2, 4, 4 };
+    for (int i = 0; i < 8; i++) {
+        lengths['A' + i] = example[i];
+    }
+    uint64_t codes[256];
+    canonicalCodes(lengths, codes);
+    uint64_t expected[8] = { 0b010, 0b011, 0b100, 0b101, 0b110, 0b00, 0b1110, 0b1111 };
+    for (int i = 0; i < 8; i++) {
+        EXPECT_EQUAL(codes['A' + i], expected[i]);
+    }
+
+    uint8_t bad[256] = { 0 };
+    bad['a'] = 1;
+    bad['b'] = 1;
+    bad['c'] = 1;
+    EXPECT_ERROR(canonicalCodes(bad, codes));
+    bad['c'] = 2;
+    EXPECT_ERROR(canonicalCodes(bad, codes));
+}
+
+STUDENT_TEST("codeLengthsFromTree / codeLengthsFromCounts") {
+    EncodingTreeNode* tree = createExampleTree();
+    uint8_t lengths[256];
+    codeLengthsFromTree(tree, lengths);
+    EXPECT_EQUAL(lengths['T'], 1);
+    EXPECT_EQUAL(lengths['E'], 2);
+    EXPECT_EQUAL(lengths['R'], 3);
+    EXPECT_EQUAL(lengths['S'], 3);
+    EXPECT_EQUAL(lengths['A'], 0);
+    deallocateTree(tree);
+
+    int64_t counts[256] = { 0 };
+    counts['a'] = 1;
+    counts['b'] = 1;
+    counts['c'] = 2;
+    counts['d'] = 4;
+    codeLengthsFromCounts(counts, lengths);
+    EXPECT_EQUAL(lengths['d'], 1);
+    EXPECT_EQUAL(lengths['c'], 2);
+    EXPECT_EQUAL(lengths['a'], 3);
+    EXPECT_EQUAL(lengths['b'], 3);
+
+    int64_t one[256] = { 0 };
+    one['z'] = 10;
+    codeLengthsFromCounts(one, lengths);
+    EXPECT_EQUAL(lengths['z'], 1);
+
+    int64_t none[256] = { 0 };
+    codeLengthsFromCounts(none, lengths);
+    for (int b = 0; b < 256; b++) {
+        EXPECT_EQUAL(lengths[b], 0);
+    }
+}
+
+STUDENT_TEST("limitedCodeLengthsFromCounts: lengths stay under the limit and cost the fewest bits") {
+    // Fibonacci counts give the deepest Huffman code: 22 values, lengths up to 21
+    int64_t counts[256] = { 0 };
+    int64_t count = 1, previous = 1;
+    for (int b = 0; b < 22; b++) {
+        counts[b] = count;
+        int64_t next = count + previous;
+        previous = count;
+        count = next;
+    }
+    auto totalBits = [&](const uint8_t lengths[256]) {
+        int64_t bits = 0;
+        for (int b = 0; b < 256; b++) {
+            bits += counts[b] * lengths[b];
+        }
+        return bits;
+    };
+    uint8_t huffman[256];
+    codeLengthsFromCounts(counts, huffman);
+    int64_t previousBits = -1;
+    for (int maxLength = 21; maxLength >= 5; maxLength--) {
+        uint8_t lengths[256];
+        limitedCodeLengthsFromCounts(counts, maxLength, lengths);
+        uint64_t space = 0;     // Kraft sum, in units of 2^-maxLength
+        for (int b = 0; b < 256; b++) {
+            EXPECT(lengths[b] <= maxLength);
+            EXPECT_EQUAL(lengths[b] > 0, counts[b] > 0);
+            if (lengths[b] > 0) {
+                space += 1ULL << (maxLength - lengths[b]);
+            }
+        }
+        EXPECT_EQUAL(space, 1ULL << maxLength);     // complete prefix code
+        int64_t bits = totalBits(lengths);
+        EXPECT(bits >= previousBits);
+        previousBits = bits;
+        if (maxLength == 21) {
+            EXPECT_EQUAL(bits, totalBits(huffman));
+        }
+    }
+    uint8_t lengths[256];
+    EXPECT_ERROR(limitedCodeLengthsFromCounts(counts, 4, lengths));
+    EXPECT_ERROR(limitedCodeLengthsFromCounts(counts, 0, lengths));
+
+    // worked by hand: under a limit of 3, the two heaviest get 2 bits and the rest 3
+    int64_t small[256] = { 0 };
+    int64_t smallCounts[6] = { 16, 8, 4, 2, 1, 1 };
+    int expected[6] = { 2, 2, 3, 3, 3, 3 };
+    for (int i = 0; i < 6; i++) {
+        small['a' + i] = smallCounts[i];
+    }
+    limitedCodeLengthsFromCounts(small, 3, lengths);
+    for (int i = 0; i < 6; i++) {
+        EXPECT_EQUAL(lengths['a' + i], expected[i]);
+    }
+}
+
+/* Helper for the test below: limitedCodeLengthsFromCounts as it was first written, keeping
+ * every item of every package-merge list and counting lengths by walking the packages.
+ */
+struct MergeItem {
+    int64_t weight;
+    int symbol;     // byte value, or -1 for a package
+    int first;      // for a package, index of its first half in the list before
+};
+
+static void countItem(const vector<vector<MergeItem>>& lists, int list, int index,
+                      uint8_t lengths[256]) {
+    const MergeItem& item = lists[list][index];
+    if (item.symbol >= 0) {
+        lengths[item.symbol]++;
+    }
+    else {
+        countItem(lists, list - 1, item.first, lengths);
+        countItem(lists, list - 1, item.first + 1, lengths);
+    }
+}
+
+static void referenceLimitedLengths(const int64_t counts[256], int maxLength, uint8_t lengths[256]) {
+    vector<MergeItem> leaves;
+    for (int b = 0; b < 256; b++) {
+        if (counts[b] > 0) {
+            leaves.push_back({ counts[b], b, 0 });
+        }
+    }
+    int n = leaves.size();
+    codeLengthsFromCounts(counts, lengths);
+    if (*max_element(lengths, lengths + 256) <= maxLength) {
+        return;
+    }
+
+    stable_sort(leaves.begin(), leaves.end(), [](const MergeItem& a, const MergeItem& b) {
+        return a.weight < b.weight;
+    });
+    vector<vector<MergeItem>> lists(maxLength);
+    lists[0] = leaves;
+    for (int list = 1; list < maxLength; list++) {
+        const vector<MergeItem>& before = lists[list - 1];
+        vector<MergeItem>& merged = lists[list];
+        int leaf = 0;
+        for (int pair = 0; pair + 1 < (int) before.size() || leaf < n; ) {
+            bool takePackage = pair + 1 < (int) before.size()
+                && (leaf == n || before[pair].weight + before[pair + 1].weight < leaves[leaf].weight);
+            if (takePackage) {
+                merged.push_back({ before[pair].weight + before[pair + 1].weight, -1, pair });
+                pair += 2;
+            }
+            else {
+                merged.push_back(leaves[leaf++]);
+            }
+        }
+    }
+
+    for (int b = 0; b < 256; b++) {
+        lengths[b] = 0;
+    }
+    for (int index = 0; index < 2 * n - 2; index++) {
+        countItem(lists, maxLength - 1, index, lengths);
+    }
+}
+
+STUDENT_TEST("limitedCodeLengthsFromCounts gives the same lengths as the full-list package-merge") {
+    for (int trial = 0; trial < 2000; trial++) {
+        // counts spread over many orders of magnitude, so most codes need limiting
+        int64_t counts[256] = { 0 };
+        int numUsed = randomInteger(2, 256);
+        for (int i = 0; i < numUsed; i++) {
+            counts[randomInteger(0, 255)] = (int64_t) randomInteger(1, 1000) << randomInteger(0, 30);
+        }
+        int used = count_if(counts, counts + 256, [](int64_t count) { return count > 0; });
+        int shortest = 1;
+        while ((1 << shortest) < used) {
+            shortest++;
+        }
+        int maxLength = randomInteger(shortest, 16);
+        uint8_t lengths[256], expected[256];
+        limitedCodeLengthsFromCounts(counts, maxLength, lengths);
+        referenceLimitedLengths(counts, maxLength, expected);
+        EXPECT(equal(lengths, lengths + 256, expected));
+    }
+}
+
+STUDENT_TEST("Length-limited codes: compression cost of each limit, and decode speed") {
+    string skewed;  // all 256 values, the rarest once and the most common 4000 times
+    for (int b = 0; b < 256; b++) {
+        skewed += string(1 + b * b * b / 4096, (char) b);
+    }
+    for (string name : { "res/constitution.txt", "res/dream.txt", "skewed" }) {
+        string base = (name == "skewed") ? skewed : readEntireFile(name);
+        cout << "    " << name << ", " << base.size() << " bytes:" << endl;
+        int64_t counts[256];
+        countBytes(base, counts);
+        uint8_t lengths[256];
+        codeLengthsFromCounts(counts, lengths);
+        int longest = *max_element(lengths, lengths + 256);
+        int64_t huffmanBits = compressCanonical(base, kMaxCodeLength).messageBits.size();
+        cout << "      unlimited (longest code " << longest << "): " << huffmanBits << " bits" << endl;
+        for (int maxLength = longest - 1; maxLength >= 8; maxLength--) {
+            CanonicalEncodedData data = compressCanonical(base, maxLength);
+            int64_t bits = data.messageBits.size();
+            cout << "      limit " << maxLength << ": " << bits << " bits, +"
+                 << 100.0 * (bits - huffmanBits) / huffmanBits << "%" << endl;
+            EXPECT(bits >= huffmanBits);
+            EXPECT_EQUAL(decompressCanonical(data), base);
+            EXPECT_EQUAL(decompressInterleaved(compressInterleaved(base, maxLength)), base);
+        }
+
+        string text;
+        while (text.size() < (16 << 20)) {
+            text += base;
+        }
+        string unlimited = compressInterleaved(text, kMaxCodeLength);
+        string limited = compressInterleaved(text);
+        string fromUnlimited, fromLimited;
+        TIME_OPERATION(text.size(), fromUnlimited = decompressInterleaved(unlimited));
+        TIME_OPERATION(text.size(), fromLimited = decompressInterleaved(limited));
+        EXPECT_EQUAL(fromUnlimited, text);
+        EXPECT_EQUAL(fromLimited, text);
+    }
+}
+
+STUDENT_TEST("packCodeLengths round trip in both forms; header smaller than the flattened tree") {
+    for (int numUsed : { 0, 1, 2, 20, 31, 32, 100, 256 }) {
+        string text;
+        for (int i = 0; i < numUsed; i++) {
+            text += string(i + 1, (char) (255 - i * 255 / max(numUsed, 1)));
+        }
+        int64_t counts[256] = { 0 };
+        for (char ch : text) {
+            counts[(unsigned char) ch]++;
+        }
+        uint8_t lengths[256];
+        codeLengthsFromCounts(counts, lengths);
+        string header = packCodeLengths(lengths);
+        uint8_t unpacked[256];
+        size_t pos = 0;
+        unpackCodeLengths(header, pos, unpacked);
+        EXPECT_EQUAL(pos, header.size());
+        for (int b = 0; b < 256; b++) {
+            EXPECT_EQUAL(unpacked[b], lengths[b]);
+        }
+        EXPECT(header.size() <= 34 + (size_t) numUsed);
+
+        if (numUsed >= 100) {
+            PackedEncodedData packed = compressPacked(text);
+            int64_t treeBytes = (packed.treeShape.size() + 7) / 8 + packed.treeLeaves.size();
+            cout << endl << "    " << numUsed << " symbols: tree header " << treeBytes
+                 << " bytes, code-length header " << header.size() << " bytes";
+            EXPECT((int64_t) header.size() < treeBytes);
+        }
+    }
+    cout << endl;
+
+    size_t pos = 0;
+    uint8_t lengths[256];
+    EXPECT_ERROR(unpackCodeLengths("", pos, lengths));
+    pos = 0;
+    EXPECT_ERROR(unpackCodeLengths(string("\x04\x03\x01\x02", 4), pos, lengths));
+}
+
+STUDENT_TEST("compressCanonical -> decompressCanonical end to end, including edge cases") {
+    for (string file : { "res/constitution.txt", "res/dream.txt" }) {
+        string text = readEntireFile(file);
+        CanonicalEncodedData data = compressCanonical(text);
+        EXPECT_EQUAL(decompressCanonical(data), text);
+        EXPECT(data.messageBits.size() <= compressPacked(text).messageBits.size());
+    }
+
+    string every;
+    for (int b = 0; b < 256; b++) {
+        every += string(b % 7 + 1, (char) b);
+    }
+    for (string text : { string(""), string("a"), string(50, 'q'), string("ab"), every }) {
+        EXPECT_EQUAL(decompressCanonical(compressCanonical(text)), text);
+    }
+
+    CanonicalEncodedData round = deserializeCanonical(serializeCanonical(compressCanonical(every)));
+    EXPECT_EQUAL(decompressCanonical(round), every);
+    EXPECT_ERROR(deserializeCanonical(serializeCanonical(compressCanonical(every)) + "x"));
+
+    CanonicalEncodedData data = compressCanonical("aaaa");   // only code is 0
+    BitWriter(data.messageBits).write(1, 1);
+    EXPECT_ERROR(decompressCanonical(data));
+}
+
+STUDENT_TEST("CanonicalDecoder: every table size, with codes longer than the table") {
+    string text;
+    int64_t count = 1, previous = 1;
+    for (char ch = 'a'; ch <= 'v'; ch++) {
+        text += string(count, ch);
+        int64_t next = count + previous;
+        previous = count;
+        count = next;
+    }
+    CanonicalEncodedData data = compressCanonical(text, kMaxCodeLength);
+    uint8_t lengths[256];
+    size_t pos = 0;
+    unpackCodeLengths(data.codeLengths, pos, lengths);
+    for (int tableBits = 1; tableBits <= 16; tableBits++) {
+        CanonicalDecoder decoder(lengths, tableBits);
+        BitReader reader(data.messageBits);
+        EXPECT_EQUAL(decoder.decode(reader), text);
+    }
+    EXPECT_ERROR(CanonicalDecoder(lengths, 0));
+}
+
+STUDENT_TEST("decompressPacked (tree) vs decompressCanonical (tree-free): time trial") {
+    string base = readEntireFile("res/constitution.txt");
+    for (int copies = 4; copies <= 16; copies *= 2) {
+        string text;
+        for (int i = 0; i < copies; i++) {
+            text += base;
+        }
+        PackedEncodedData packed = compressPacked(text);
+        CanonicalEncodedData canonical = compressCanonical(text);
+        cout << "    message bits: tree " << packed.messageBits.size() << ", canonical "
+             << canonical.messageBits.size() << endl;
+        string fromTree, fromCanonical;
+        TIME_OPERATION(text.size(), fromTree = decompressPacked(packed));
+        TIME_OPERATION(text.size(), fromCanonical = decompressCanonical(canonical));
+        EXPECT_EQUAL(fromTree, text);
+        EXPECT_EQUAL(fromCanonical, text);
+    }
+}
+
+STUDENT_TEST("compressInterleaved -> decompressInterleaved, every length mod 4, and bad input") {
+    for (string file : { "res/constitution.txt", "res/dream.txt" }) {
+        string text = readEntireFile(file);
+        string bytes = compressInterleaved(text);
+        EXPECT_EQUAL(decompressInterleaved(bytes), text);
+        EXPECT(bytes.size() <= serializeCanonical(compressCanonical(text)).size() + 20);
+        EXPECT(bytes.size() <= maxInterleavedSize(text.size()));
+    }
+    string text = readEntireFile("res/dream.txt");
+    for (int length = 0; length <= 13; length++) {
+        EXPECT_EQUAL(decompressInterleaved(compressInterleaved(text.substr(0, length))), text.substr(0, length));
+    }
+    EXPECT_EQUAL(decompressInterleaved(compressInterleaved(string(1001, 'q'))), string(1001, 'q'));
+
+    string bytes = compressInterleaved(text);
+    EXPECT_ERROR(decompressInterleaved(bytes.substr(0, bytes.size() - 1)));
+    EXPECT_ERROR(decompressInterleaved(bytes + "x"));
+    EXPECT_ERROR(decompressInterleaved(bytes.substr(0, 40)));
+}
+
+STUDENT_TEST("CanonicalDecoder::decodeInterleaved agrees with decode, and rejects bad streams") {
+    string text = readEntireFile("res/constitution.txt");
+    CanonicalEncodedData data = compressCanonical(text);
+    uint8_t lengths[256];
+    size_t pos = 0;
+    unpackCodeLengths(data.codeLengths, pos, lengths);
+    for (int tableBits : { 1, 5, 10, 12 }) {
+        CanonicalDecoder decoder(lengths, tableBits);
+        EXPECT_EQUAL(decoder.decodeInterleaved(&data.messageBits, 1, text.size()), text);
+        EXPECT_ERROR(decoder.decodeInterleaved(&data.messageBits, 1, text.size() + 1));
+        EXPECT_ERROR(decoder.decodeInterleaved(&data.messageBits, 1, text.size() - 1));
+        EXPECT_ERROR(decoder.decodeInterleaved(&data.messageBits, 2, text.size()));
+    }
+}
+
+STUDENT_TEST("CanonicalDecoder: one stream vs four interleaved streams, time trial") {
+    for (string file : { "res/constitution.txt", "res/dream.txt" }) {
+        string base = readEntireFile(file);
+        string text;
+        while (text.size() < (16 << 20)) {
+            text += base;
+        }
+        CanonicalEncodedData single = compressCanonical(text);
+        string interleaved = compressInterleaved(text);
+
+        uint8_t lengths[256];
+        size_t pos = 0;
+        unpackCodeLengths(single.codeLengths, pos, lengths);
+        CanonicalDecoder decoder(lengths);
+
+        cout << "    " << file << ":" << endl;
+        string fromBitReader, fromOneStream, fromFourStreams;
+        TIME_OPERATION(text.size(), fromBitReader = decompressCanonical(single));
+        TIME_OPERATION(text.size(), fromOneStream = decoder.decodeInterleaved(&single.messageBits, 1, text.size()));
+        TIME_OPERATION(text.size(), fromFourStreams = decompressInterleaved(interleaved));
+        EXPECT_EQUAL(fromBitReader, text);
+        EXPECT_EQUAL(fromOneStream, text);
+        EXPECT_EQUAL(fromFourStreams, text);
+    }
+}
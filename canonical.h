@@ -0,0 +1,213 @@
+/* File: canonical.h
+ * Assignment brief: canonical Huffman codes. Instead of storing the tree (flattenTree's
+ * treeShape and treeLeaves), only the code length of each byte value is stored. Codes are
+ * then assigned in a fixed order: shorter codes first, and within one length in order of
+ * byte value, each code one more than the previous (shifted left when the length grows).
+ * The decoder rebuilds its tables from the lengths alone, without allocating any nodes.
+ */
+#pragma once
+#include "testing/MemoryUtils.h"
+#include "bitbuffer.h"
+#include <cstdint>
+#include <string>
+
+/**
+ * Longest code length supported, so that a code always fits in one BitReader::peek and
+ * 2^length fits in a uint64_t.
+ */
+const int kMaxCodeLength = 63;
+
+/**
+ * Fills lengths[b] with the Huffman code length for byte value b given how many times
+ * each byte value occurs (counts[b]). Unused values get length 0. If only one value
+ * occurs it gets length 1, so text with a single distinct character can still be coded.
+ *
+ * Reports an error if a code would be longer than kMaxCodeLength (this takes a total
+ * count in the tens of trillions).
+ */
+void codeLengthsFromCounts(const int64_t counts[256], uint8_t lengths[256]);
+
+/**
+ * Code length limit that compressCanonical and compressInterleaved use unless told
+ * otherwise. Every code of at most 12 bits is resolved by one lookup in a 2^12-entry
+ * table (8 KB, small enough to stay in L1 cache), so the decoder never needs its slow
+ * path for longer codes.
+ */
+const int kDefaultCodeLengthLimit = 12;
+
+/**
+ * Like codeLengthsFromCounts, but no code is longer than maxLength bits. Of all prefix
+ * codes that meet the limit, the lengths give one with the fewest total message bits.
+ * When the Huffman code already meets the limit it is returned unchanged.
+ *
+ * Reports an error if maxLength is not between 1 and kMaxCodeLength, or is too short to
+ * give every used byte value its own code (2^maxLength is less than their number).
+ */
+void limitedCodeLengthsFromCounts(const int64_t counts[256], int maxLength, uint8_t lengths[256]);
+
+/**
+ * Fills lengths[b] with the depth of byte value b in tree, or 0 if it isn't in the tree.
+ *
+ * Reports an error if the tree is deeper than kMaxCodeLength.
+ */
+void codeLengthsFromTree(EncodingTreeNode* tree, uint8_t lengths[256]);
+
+/**
+ * Fills codes[b] with the canonical code for every byte value with a nonzero length (the
+ * code is the low lengths[b] bits).
+ *
+ * Reports an error if the lengths don't describe a prefix code.
+ */
+void canonicalCodes(const uint8_t lengths[256], uint64_t codes[256]);
+
+/**
+ * Serializes code lengths compactly. The first byte says which form follows and how many
+ * bits each length takes (4 if every length is at most 15, otherwise 7):
+ *     sparse: number of used values, the used values in increasing order, their lengths
+ *     bitmap: 32-byte bitmap of the used values, their lengths
+ * The bitmap form is chosen when it is smaller, i.e. for large alphabets.
+ */
+std::string packCodeLengths(const uint8_t lengths[256]);
+
+/**
+ * Inverse of packCodeLengths, reading from bytes at pos and moving pos past the header.
+ *
+ * Reports an error if the header is truncated or malformed.
+ */
+void unpackCodeLengths(const std::string& bytes, size_t& pos, uint8_t lengths[256]);
+
+/**
+ * Number of bitstreams the interleaved coding deals a message into.
+ */
+const int kInterleavedStreams = 4;
+
+/**
+ * Tree-free decoder for canonical codes. Codes of at most tableBits bits are resolved with
+ * one lookup. Longer codes are found with the canonical first-code-per-length rule: for
+ * each length L past tableBits, the next L bits are a code of length L exactly when they
+ * fall among the count[L] codes starting at firstCode[L].
+ */
+class CanonicalDecoder {
+public:
+    /**
+     * Builds the decoder from code lengths.
+     *
+     * Reports an error if tableBits is not between 1 and 16 or the lengths don't describe a
+     * prefix code.
+     */
+    CanonicalDecoder(const uint8_t lengths[256], int tableBits = 10);
+
+    ~CanonicalDecoder();
+
+    /**
+     * Decodes every bit left in bits and returns the message.
+     *
+     * Reports an error on a bit pattern that isn't a code, or if the bits end in the
+     * middle of a code.
+     */
+    std::string decode(BitReader& bits) const;
+
+    /**
+     * Decodes the next count characters from bits into out[0 .. count), leaving any bits
+     * after them unread.
+     *
+     * Reports an error on a bit pattern that isn't a code, or if the bits run out first.
+     */
+    void decode(BitReader& bits, char* out, int64_t count) const;
+
+    /**
+     * Decodes a message of length characters that was dealt round-robin into numStreams
+     * bitstreams (character i in streams[i % numStreams]). The streams are decoded
+     * together, one character from each per step. Their bit positions don't depend on
+     * each other, so the CPU can work on all of them at once instead of waiting on one
+     * chain of lookups.
+     *
+     * Reports an error if numStreams is not 1 or kInterleavedStreams, on a bit pattern
+     * that isn't a code, or if any stream does not end exactly after its last code.
+     */
+    std::string decodeInterleaved(const BitBuffer streams[], int numStreams, int64_t length) const;
+
+private:
+    struct Entry {
+        uint8_t symbol;
+        uint8_t length;     // 0 if the code is longer than tableBits (or not a code)
+    };
+
+    Entry* _entries;
+    int _tableBits;
+    int _maxLength;
+    uint64_t _firstCode[kMaxCodeLength + 1];   // first canonical code of each length
+    int _firstIndex[kMaxCodeLength + 1];       // index in _symbols of that code's symbol
+    int _count[kMaxCodeLength + 1];            // number of codes of each length
+    uint8_t _symbols[256];                     // used byte values ordered by (length, value)
+
+    int decodeLong(BitReader& bits) const;
+
+    DISALLOW_COPYING_OF(CanonicalDecoder);
+};
+
+/**
+ * Canonical counterpart of PackedEncodedData: the header from packCodeLengths in place of
+ * the tree, and the message bits.
+ */
+struct CanonicalEncodedData {
+    std::string codeLengths;
+    BitBuffer messageBits;
+};
+
+/**
+ * Serializes data as the code-length header, the number of message bits as a varint, and
+ * the message bits packed 8 to a byte.
+ */
+std::string serializeCanonical(const CanonicalEncodedData& data);
+
+/**
+ * Returns the most bytes serializeCanonical can produce for a message of messageLength
+ * bytes, so readers can check a stored length before allocating for it.
+ */
+uint64_t maxSerializedCanonicalSize(uint64_t messageLength);
+
+/**
+ * Inverse of serializeCanonical.
+ *
+ * Reports an error if bytes is truncated or has extra bytes at the end.
+ */
+CanonicalEncodedData deserializeCanonical(const std::string& bytes);
+
+/**
+ * Huffman-codes messageText with canonical codes of at most maxLength bits (see
+ * limitedCodeLengthsFromCounts). Unlike compress, text with fewer than two distinct
+ * characters (including the empty string) is allowed.
+ */
+CanonicalEncodedData compressCanonical(const std::string& messageText,
+                                       int maxLength = kDefaultCodeLengthLimit);
+
+/**
+ * Inverse of compressCanonical. The decoder's table is as wide as the longest code, up
+ * to kDefaultCodeLengthLimit bits.
+ *
+ * Reports an error if data is malformed.
+ */
+std::string decompressCanonical(const CanonicalEncodedData& data);
+
+/**
+ * Canonical coding with the message dealt round-robin into kInterleavedStreams bitstreams,
+ * so it can be decoded with CanonicalDecoder::decodeInterleaved. Serialized as the
+ * code-length header, the message length and the bit count of each stream as varints,
+ * then each stream's bits packed 8 to a byte. No code is longer than maxLength bits.
+ */
+std::string compressInterleaved(const std::string& messageText,
+                                int maxLength = kDefaultCodeLengthLimit);
+
+/**
+ * Returns the most bytes compressInterleaved can produce for a message of messageLength
+ * bytes.
+ */
+uint64_t maxInterleavedSize(uint64_t messageLength);
+
+/**
+ * Inverse of compressInterleaved.
+ *
+ * Reports an error if bytes is truncated, malformed, or has extra bytes at the end.
+ */
+std::string decompressInterleaved(const std::string& bytes);
@@ -0,0 +1,103 @@
+/* File: crc32c.cpp
+ * Assignment brief: CRC-32C checksums. The header file, "crc32c.h" is in this repository.
+ */
+#include "crc32c.h"
+#include "strlib.h"
+#include <cstring>
+#include <string>
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/* Bit-reversed Castagnoli polynomial 0x1EDC6F41. */
+const uint32_t kCrc32cPolynomial = 0x82F63B78;
+
+/*
+ * tables[0][b] is the CRC of the single byte b. tables[k][b] is the CRC of byte b followed
+ * by k zero bytes, so eight bytes can be folded in with one lookup each.
+ */
+struct Crc32cTables {
+    uint32_t tables[8][256];
+
+    Crc32cTables() {
+        for (uint32_t b = 0; b < 256; b++) {
+            uint32_t crc = b;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ ((crc & 1) ? kCrc32cPolynomial : 0);
+            }
+            tables[0][b] = crc;
+        }
+        for (int k = 1; k < 8; k++) {
+            for (int b = 0; b < 256; b++) {
+                uint32_t previous = tables[k - 1][b];
+                tables[k][b] = (previous >> 8) ^ tables[0][previous & 0xFF];
+            }
+        }
+    }
+};
+
+/*
+ * The CRC register is little-endian, so the low four bytes of each 8-byte load are the
+ * ones XORed with it. The tables are a function-local static, built on the first call.
+ */
+uint32_t crc32c(const char* data, size_t size, uint32_t crc) {
+    static const Crc32cTables crcTables;
+    const uint32_t (*t)[256] = crcTables.tables;
+    const unsigned char* bytes = (const unsigned char*) data;
+    crc = ~crc;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint32_t low, high;
+        memcpy(&low, bytes + i, 4);
+        memcpy(&high, bytes + i + 4, 4);
+        low ^= crc;
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+              t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+    }
+    for (; i < size; i++) {
+        crc = (crc >> 8) ^ t[0][(crc ^ bytes[i]) & 0xFF];
+    }
+    return ~crc;
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * */
+
+/* Helper that computes the CRC one bit at a time, straight from the definition. */
+static uint32_t crc32cBitwise(const string& text) {
+    uint32_t crc = ~0u;
+    for (char ch : text) {
+        crc ^= (unsigned char) ch;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? kCrc32cPolynomial : 0);
+        }
+    }
+    return ~crc;
+}
+
+STUDENT_TEST("crc32c: standard check values, bitwise agreement, and chaining") {
+    EXPECT_EQUAL(crc32c("", 0), 0u);
+    EXPECT_EQUAL(crc32c("123456789", 9), 0xE3069283u);
+    string zeros(32, '\0');
+    EXPECT_EQUAL(crc32c(zeros.data(), 32), 0x8A9136AAu);   // RFC 3720 B.4
+
+    string text;
+    for (int i = 0; i < 1000; i++) {
+        text += (char) randomInteger(0, 255);
+    }
+    for (size_t length = 0; length <= 40; length++) {
+        EXPECT_EQUAL(crc32c(text.data(), length), crc32cBitwise(text.substr(0, length)));
+    }
+    for (size_t split : { (size_t) 0, (size_t) 1, (size_t) 13, (size_t) 500, text.size() }) {
+        uint32_t first = crc32c(text.data(), split);
+        EXPECT_EQUAL(crc32c(text.data() + split, text.size() - split, first), crc32c(text.data(), text.size()));
+    }
+}
+
+STUDENT_TEST("crc32c: time trial and throughput") {
+    for (size_t size : { (size_t) 1 << 22, (size_t) 1 << 24 }) {
+        string data(size, 'x');
+        uint32_t crc = 0;
+        TIME_OPERATION(size, crc = crc32c(data.data(), size));
+        EXPECT(crc != 0);
+    }
+}
@@ -0,0 +1,443 @@
+/* File: dparchive.cpp
+ * Assignment brief: columnar archive format for DataPoint streams. Priorities and names are
+ * stored as separate columns and each column is compressed with the Huffman coder from
+ * huffman.cpp. The header file, "dparchive.h" is in this repository, along with a
+ * description of the layout.
+ */
+#include "dparchive.h"
+#include "byteio.h"
+#include "dpbinary.h"
+#include "huffmantable.h"
+#include "pqclient.h"
+#include "pqheap.h"
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include <climits>
+#include <sstream>
+#include "testing/SimpleTest.h"
+using namespace std;
+
+const string kArchiveMagic = "DPA1";
+const char MODE_RAW = 0;
+const char MODE_HUFFMAN = 1;
+
+/* HELPER FUNCTION: appends the number of bits, then the bits packed 8 to a byte (first bit
+ * in the high bit of the first byte). Empties bits.
+ */
+static void packBits(string& out, Queue<Bit>& bits) {
+    appendU32(out, bits.size());
+    int byte = 0;
+    int filled = 0;
+    while (!bits.isEmpty()) {
+        byte = (byte << 1) | (bits.dequeue() == 1 ? 1 : 0);
+        filled++;
+        if (filled == 8) {
+            out += (char) byte;
+            byte = 0;
+            filled = 0;
+        }
+    }
+    if (filled > 0) {
+        out += (char) (byte << (8 - filled));
+    }
+}
+
+/* HELPER FUNCTION: inverse of packBits, reading from bytes starting at pos. */
+static Queue<Bit> unpackBits(const string& bytes, size_t& pos) {
+    if (pos + 4 > bytes.size()) {
+        error("unpackEncodedData: truncated data");
+    }
+    uint32_t count = readU32(bytes.data(), pos);
+    pos += 4;
+    if ((count + 7) / 8 > bytes.size() - pos) {
+        error("unpackEncodedData: truncated data");
+    }
+    Queue<Bit> bits;
+    for (uint32_t i = 0; i < count; i++) {
+        unsigned char byte = bytes[pos + i / 8];
+        bits.enqueue((byte >> (7 - i % 8)) & 1);
+    }
+    pos += (count + 7) / 8;
+    return bits;
+}
+
+string packEncodedData(EncodedData& data) {
+    string out;
+    packBits(out, data.treeShape);
+    appendU32(out, data.treeLeaves.size());
+    while (!data.treeLeaves.isEmpty()) {
+        out += data.treeLeaves.dequeue();
+    }
+    packBits(out, data.messageBits);
+    return out;
+}
+
+/* HELPER FUNCTION: reads the treeShape and treeLeaves parts of a packed EncodedData into
+ * data, moving pos past them.
+ */
+static void unpackTree(const string& bytes, size_t& pos, EncodedData& data) {
+    data.treeShape = unpackBits(bytes, pos);
+    if (pos + 4 > bytes.size()) {
+        error("unpackEncodedData: truncated data");
+    }
+    uint32_t numLeaves = readU32(bytes.data(), pos);
+    pos += 4;
+    if (numLeaves > bytes.size() - pos) {
+        error("unpackEncodedData: truncated data");
+    }
+    for (uint32_t i = 0; i < numLeaves; i++) {
+        data.treeLeaves.enqueue(bytes[pos++]);
+    }
+}
+
+EncodedData unpackEncodedData(const string& bytes) {
+    EncodedData data;
+    size_t pos = 0;
+    unpackTree(bytes, pos, data);
+    data.messageBits = unpackBits(bytes, pos);
+    return data;
+}
+
+/* HELPER FUNCTION: decompresses a packed Huffman column. Only the tree goes through
+ * queues; the message bits are decoded straight from the packed bytes with a
+ * HuffmanDecodeTable.
+ */
+static string decodeHuffmanColumn(const string& bytes) {
+    EncodedData data;
+    size_t pos = 0;
+    unpackTree(bytes, pos, data);
+    if (pos + 4 > bytes.size()) {
+        error("unpackEncodedData: truncated data");
+    }
+    uint32_t numBits = readU32(bytes.data(), pos);
+    pos += 4;
+    if ((numBits + 7) / 8 > bytes.size() - pos) {
+        error("unpackEncodedData: truncated data");
+    }
+    EncodingTreeNode* tree = unflattenTree(data.treeShape, data.treeLeaves);
+    HuffmanDecodeTable table(tree);
+    string raw = table.decode(bytes.data() + pos, numBits);
+    deallocateTree(tree);
+    return raw;
+}
+
+/* HELPER FUNCTION: appends one column to out, Huffman coded if that is possible and
+ * actually makes it smaller, otherwise raw.
+ */
+static void writeColumn(string& out, const string& raw) {
+    bool twoDistinct = false;
+    for (char ch : raw) {
+        if (ch != raw[0]) {
+            twoDistinct = true;
+            break;
+        }
+    }
+
+    string encoded;
+    char mode = MODE_RAW;
+    if (twoDistinct) {
+        EncodedData data = compress(raw);
+        encoded = packEncodedData(data);
+        if (encoded.size() < raw.size()) {
+            mode = MODE_HUFFMAN;
+        }
+    }
+    const string& body = (mode == MODE_HUFFMAN) ? encoded : raw;
+    out += mode;
+    appendU32(out, raw.size());
+    appendU32(out, body.size());
+    out += body;
+}
+
+/* HELPER FUNCTION: reads one column from in and returns its raw bytes. */
+static string readColumn(istream& in) {
+    char header[9];
+    if (!in.read(header, 9)) {
+        error("DataPointArchiveReader: truncated column header");
+    }
+    uint32_t rawLength = readU32(header, 1);
+    uint32_t bodyLength = readU32(header, 5);
+    string body(bodyLength, '\0');
+    if (bodyLength > 0 && !in.read(&body[0], bodyLength)) {
+        error("DataPointArchiveReader: truncated column");
+    }
+
+    string raw;
+    if (header[0] == MODE_RAW) {
+        raw = body;
+    }
+    else if (header[0] == MODE_HUFFMAN) {
+        raw = decodeHuffmanColumn(body);
+    }
+    else {
+        error("DataPointArchiveReader: unknown column mode");
+    }
+    if (raw.size() != rawLength) {
+        error("DataPointArchiveReader: column length mismatch");
+    }
+    return raw;
+}
+
+DataPointArchiveWriter::DataPointArchiveWriter(ostream& out, int recordsPerBlock) : _out(out) {
+    if (recordsPerBlock <= 0) {
+        error("DataPointArchiveWriter: recordsPerBlock must be positive");
+    }
+    _recordsPerBlock = recordsPerBlock;
+    _blockCount = 0;
+    _previousPriority = 0;
+    _closed = false;
+    _out.write(kArchiveMagic.data(), kArchiveMagic.size());
+}
+
+DataPointArchiveWriter::~DataPointArchiveWriter() {
+    if (!_closed) {
+        close();
+    }
+}
+
+/*
+ * Splits the record across the two raw columns. Nothing is compressed until the block
+ * is full.
+ */
+void DataPointArchiveWriter::write(const DataPoint& point) {
+    if (_closed) {
+        error("DataPointArchiveWriter: write after close");
+    }
+    appendVarint(_priorities, zigzagEncode((int64_t) point.priority - _previousPriority));
+    _previousPriority = point.priority;
+    appendVarint(_names, point.name.size());
+    _names += point.name;
+    _blockCount++;
+    if (_blockCount == _recordsPerBlock) {
+        flushBlock();
+    }
+}
+
+/* HELPER FUNCTION: compresses both columns of the current block and writes them out. The
+ * delta chain restarts at 0 in every block so blocks can be decoded on their own.
+ */
+void DataPointArchiveWriter::flushBlock() {
+    string block;
+    appendU32(block, _blockCount);
+    writeColumn(block, _priorities);
+    writeColumn(block, _names);
+    _out.write(block.data(), block.size());
+    _priorities.clear();
+    _names.clear();
+    _blockCount = 0;
+    _previousPriority = 0;
+}
+
+void DataPointArchiveWriter::close() {
+    if (_blockCount > 0) {
+        flushBlock();
+    }
+    string end;
+    appendU32(end, 0);
+    _out.write(end.data(), end.size());
+    _out.flush();
+    _closed = true;
+}
+
+DataPointArchiveReader::DataPointArchiveReader(istream& in) : _in(in) {
+    char magic[4];
+    if (!_in.read(magic, 4) || string(magic, 4) != kArchiveMagic) {
+        error("DataPointArchiveReader: stream is not a DataPoint archive");
+    }
+    _priorityPos = 0;
+    _namePos = 0;
+    _previousPriority = 0;
+    _remaining = 0;
+    _done = false;
+}
+
+/* HELPER FUNCTION: reads and decompresses the next block. Returns false at the end marker. */
+bool DataPointArchiveReader::loadBlock() {
+    char header[4];
+    if (!_in.read(header, 4)) {
+        error("DataPointArchiveReader: archive ended without an end marker");
+    }
+    uint32_t count = readU32(header, 0);
+    if (count == 0) {
+        _done = true;
+        return false;
+    }
+    _priorities = readColumn(_in);
+    _names = readColumn(_in);
+    _priorityPos = 0;
+    _namePos = 0;
+    _previousPriority = 0;
+    _remaining = count;
+    return true;
+}
+
+bool DataPointArchiveReader::next(DataPoint& point) {
+    if (_done) {
+        return false;
+    }
+    if (_remaining == 0 && !loadBlock()) {
+        return false;
+    }
+    size_t pos = _priorityPos;
+    // Sum in 64 bits: a delta between two ints can be far outside int range, and only a
+    // corrupt column makes the sum leave it.
+    int64_t delta = zigzagDecode(readVarint(_priorities.data(), _priorities.size(), pos));
+    if (delta < (int64_t) INT_MIN - INT_MAX || delta > (int64_t) INT_MAX - INT_MIN) {
+        error("DataPointArchiveReader: malformed priority column");
+    }
+    int64_t priority = _previousPriority + delta;
+    if (priority < INT_MIN || priority > INT_MAX) {
+        error("DataPointArchiveReader: malformed priority column");
+    }
+    _previousPriority = (int) priority;
+    _priorityPos = pos;
+    point.priority = _previousPriority;
+
+    pos = _namePos;
+    uint64_t length = readVarint(_names.data(), _names.size(), pos);
+    if (length > _names.size() - pos) {
+        error("DataPointArchiveReader: malformed name column");
+    }
+    point.name.assign(_names.data() + pos, length);
+    _namePos = pos + length;
+    _remaining--;
+    return true;
+}
+
+void convertTextToArchive(istream& text, ostream& archive, int recordsPerBlock) {
+    DataPointArchiveWriter writer(archive, recordsPerBlock);
+    DataPoint point;
+    while (text >> point) {
+        writer.write(point);
+    }
+    writer.close();
+}
+
+/*
+ * Same bounded PQHeap as topK, fed from the archive reader.
+ */
+Vector<DataPoint> topKArchive(istream& archive, int k) {
+    DataPointArchiveReader reader(archive);
+    PQHeap pq;
+    DataPoint point;
+    while (reader.next(point)) {
+        offerTopK(pq, point, k);
+    }
+    return drainDescending(pq);
+}
+
+Vector<DataPoint> pqSortArchive(istream& archive) {
+    DataPointArchiveReader reader(archive);
+    Vector<DataPoint> result;
+    DataPoint point;
+    while (reader.next(point)) {
+        result.add(point);
+    }
+    pqSort(result);
+    return result;
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+/* Helper function that archives dataPoints and returns the archive bytes. */
+static string asArchive(const Vector<DataPoint>& dataPoints, int recordsPerBlock = 65536) {
+    stringstream out;
+    DataPointArchiveWriter writer(out, recordsPerBlock);
+    for (const DataPoint& pt : dataPoints) {
+        writer.write(pt);
+    }
+    writer.close();
+    return out.str();
+}
+
+/* Helper function that reads every record of an archive. */
+static Vector<DataPoint> readArchive(const string& bytes) {
+    stringstream in(bytes);
+    DataPointArchiveReader reader(in);
+    Vector<DataPoint> result;
+    DataPoint point;
+    while (reader.next(point)) {
+        result.add(point);
+    }
+    return result;
+}
+
+STUDENT_TEST("packEncodedData / unpackEncodedData round trip") {
+    EncodedData data = compress("STREETTEST");
+    EncodedData copy = data;
+    EncodedData unpacked = unpackEncodedData(packEncodedData(data));
+    EXPECT_EQUAL(unpacked.treeShape, copy.treeShape);
+    EXPECT_EQUAL(unpacked.treeLeaves, copy.treeLeaves);
+    EXPECT_EQUAL(unpacked.messageBits, copy.messageBits);
+    EXPECT_ERROR(unpackEncodedData("\x05"));
+}
+
+STUDENT_TEST("archive round trip: raw and Huffman columns, extreme priorities, block boundaries") {
+    Vector<DataPoint> input = { { "sensor-a", 2147483647 }, { "sensor-b", -2147483647 - 1 },
+                                { "", 0 }, { string("nul\0", 4), 5 } };
+    for (int i = 0; i < 500; i++) {
+        input.add({ "sensor-" + integerToString(i % 7), 1000 + i });
+    }
+    for (int perBlock : { 1, 3, 100, 65536 }) {
+        EXPECT_EQUAL(readArchive(asArchive(input, perBlock)), input);
+    }
+
+    // a block whose columns each have only one distinct byte has to be stored raw
+    Vector<DataPoint> same = { { "", 0 }, { "", 0 }, { "", 0 } };
+    EXPECT_EQUAL(readArchive(asArchive(same)), same);
+    EXPECT_EQUAL(readArchive(asArchive({})), Vector<DataPoint>());
+
+    stringstream text("{ \"A\", 1 }");
+    EXPECT_ERROR(DataPointArchiveReader{ text });
+
+    // a delta that steps past INT_MAX is malformed, not wrapped around
+    string priorities, names, corrupt = "DPA1";
+    appendVarint(priorities, zigzagEncode(INT_MAX));
+    appendVarint(priorities, zigzagEncode(1));
+    appendVarint(names, 0);
+    appendVarint(names, 0);
+    appendU32(corrupt, 2);
+    writeColumn(corrupt, priorities);
+    writeColumn(corrupt, names);
+    appendU32(corrupt, 0);
+    EXPECT_ERROR(readArchive(corrupt));
+}
+
+STUDENT_TEST("archive is much smaller than text, and topKArchive / pqSortArchive agree with the text versions") {
+    Vector<DataPoint> input;
+    int priority = 1000000;
+    for (int i = 0; i < 20000; i++) {
+        priority += randomInteger(-50, 50);
+        input.add({ "tenant-" + integerToString(randomInteger(1, 20)), priority });
+    }
+    stringstream text;
+    for (const DataPoint& pt : input) {
+        text << pt;
+    }
+    string textBytes = text.str();
+    stringstream archive;
+    convertTextToArchive(text, archive, 4096);
+    string archiveBytes = archive.str();
+    EXPECT(archiveBytes.size() * 4 < textBytes.size());
+
+    stringstream binary;
+    stringstream textCopy(textBytes);
+    convertTextToBinary(textCopy, binary);
+    EXPECT(archiveBytes.size() * 2 < binary.str().size());
+
+    stringstream archiveIn(archiveBytes);
+    Vector<DataPoint> expected = topK(input, 10);
+    Vector<DataPoint> result = topKArchive(archiveIn, 10);
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQUAL(result[i].priority, expected[i].priority);
+    }
+
+    stringstream archiveAgain(archiveBytes);
+    Vector<DataPoint> sorted = pqSortArchive(archiveAgain);
+    EXPECT_EQUAL(sorted.size(), input.size());
+    for (int i = 1; i < sorted.size(); i++) {
+        EXPECT(sorted[i - 1].priority <= sorted[i].priority);
+    }
+}
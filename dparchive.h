@@ -0,0 +1,137 @@
+/* File: dparchive.h
+ * Assignment brief: columnar archive format for DataPoint streams. Priorities and names are
+ * stored as separate columns and each column is compressed with the Huffman coder from
+ * huffman.cpp, so large archives take much less disk space and I/O than text.
+ *
+ * Layout (integers are little-endian u32 unless noted):
+ *
+ *     archive := "DPA1" block* 0
+ *     block   := recordCount column(priorities) column(names)
+ *     column  := mode:u8 rawLength encodedLength encodedBytes{encodedLength}
+ *
+ * Raw priority column: each priority minus the previous one in the block (the first is
+ * relative to 0), zigzag-encoded and written as a base-128 varint. Sorted or slowly
+ * changing priorities become runs of small, repetitive bytes.
+ * Raw name column: for each name, its length as a varint followed by its bytes.
+ *
+ * mode 1 means the column was compressed with compress() and the encodedBytes are the
+ * EncodedData packed by packEncodedData(). mode 0 means the raw bytes are stored as-is,
+ * which is used when a column has fewer than two distinct bytes (compress() can't code
+ * those) or when Huffman coding would not make it smaller. Every block is coded
+ * independently, so a reader only ever holds one block in memory.
+ */
+#pragma once
+#include "testing/MemoryUtils.h"
+#include "datapoint.h"
+#include "huffman.h"
+#include "vector.h"
+#include <istream>
+#include <ostream>
+#include <string>
+
+/**
+ * Writes DataPoints to an output stream in the archive format, recordsPerBlock at a time.
+ */
+class DataPointArchiveWriter {
+public:
+    /**
+     * Creates a writer and writes the archive header to out.
+     *
+     * Reports an error if recordsPerBlock is not positive.
+     */
+    DataPointArchiveWriter(std::ostream& out, int recordsPerBlock = 65536);
+
+    /**
+     * Calls close() if it hasn't been called yet.
+     */
+    ~DataPointArchiveWriter();
+
+    /**
+     * Appends one record. The block is compressed and written when it fills up.
+     */
+    void write(const DataPoint& point);
+
+    /**
+     * Writes any partially filled block, then the end marker.
+     */
+    void close();
+
+private:
+    std::ostream& _out;
+    std::string _priorities;    // raw priority column of the current block
+    std::string _names;         // raw name column of the current block
+    int _blockCount;
+    int _previousPriority;
+    int _recordsPerBlock;
+    bool _closed;
+
+    void flushBlock();
+
+    DISALLOW_COPYING_OF(DataPointArchiveWriter);
+};
+
+/**
+ * Reads DataPoints back from the archive format, decompressing one block at a time.
+ */
+class DataPointArchiveReader {
+public:
+    /**
+     * Creates a reader and checks the archive header.
+     *
+     * Reports an error if in does not start with the archive magic number.
+     */
+    DataPointArchiveReader(std::istream& in);
+
+    /**
+     * Reads the next record into point and returns true, or returns false at the end of
+     * the archive.
+     *
+     * Reports an error if the archive is truncated or malformed.
+     */
+    bool next(DataPoint& point);
+
+private:
+    std::istream& _in;
+    std::string _priorities;    // decompressed priority column of the current block
+    std::string _names;         // decompressed name column of the current block
+    int _priorityPos;
+    int _namePos;
+    int _previousPriority;
+    int _remaining;
+    bool _done;
+
+    bool loadBlock();
+
+    DISALLOW_COPYING_OF(DataPointArchiveReader);
+};
+
+/**
+ * Packs data into bytes: the number of treeShape bits, the treeShape bits 8 to a byte, the
+ * number of leaves, the leaf characters, the number of messageBits, and the messageBits 8
+ * to a byte. data's queues are emptied.
+ */
+std::string packEncodedData(EncodedData& data);
+
+/**
+ * Inverse of packEncodedData.
+ *
+ * Reports an error if bytes is truncated.
+ */
+EncodedData unpackEncodedData(const std::string& bytes);
+
+/**
+ * Reads text-format DataPoints from text until it runs out, and writes them to archive.
+ */
+void convertTextToArchive(std::istream& text, std::ostream& archive, int recordsPerBlock = 65536);
+
+/**
+ * Archive version of topK. Same behavior as topK(std::istream&, int), but reading records
+ * with a DataPointArchiveReader.
+ */
+Vector<DataPoint> topKArchive(std::istream& archive, int k);
+
+/**
+ * Archive version of pqSort: reads every record in archive and returns them sorted in
+ * increasing order of weight.
+ */
+Vector<DataPoint> pqSortArchive(std::istream& archive);
@@ -0,0 +1,254 @@
+/* File: dpbinary.cpp
+ * Assignment brief: compact binary record format for DataPoint streams, so that topK and
+ * pqSort can skip the text operator<< / operator>> round trip. The header file,
+ * "dpbinary.h" is in this repository, along with a description of the layout.
+ */
+#include "dpbinary.h"
+#include "byteio.h"
+#include "pqclient.h"
+#include "pqheap.h"
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include <cstdint>
+#include <sstream>
+#include "testing/SimpleTest.h"
+using namespace std;
+
+const char kBinaryMagic[] = "DPB1";
+
+BinaryDataPointWriter::BinaryDataPointWriter(ostream& out, int recordsPerBlock) : _out(out) {
+    if (recordsPerBlock <= 0) {
+        error("BinaryDataPointWriter: recordsPerBlock must be positive");
+    }
+    _recordsPerBlock = recordsPerBlock;
+    _blockCount = 0;
+    _closed = false;
+    _out.write(kBinaryMagic, 4);
+}
+
+BinaryDataPointWriter::~BinaryDataPointWriter() {
+    if (!_closed) {
+        close();
+    }
+}
+
+/*
+ * Encodes the record onto the end of the current block. The block string keeps its
+ * capacity after a flush, so steady-state writing does not allocate.
+ */
+void BinaryDataPointWriter::write(const DataPoint& point) {
+    if (_closed) {
+        error("BinaryDataPointWriter: write after close");
+    }
+    appendU32(_block, (uint32_t) point.priority);
+    appendU32(_block, (uint32_t) point.name.size());
+    _block += point.name;
+    _blockCount++;
+    if (_blockCount == _recordsPerBlock) {
+        flushBlock();
+    }
+}
+
+/* HELPER FUNCTION: writes the block header and payload, then empties the block. */
+void BinaryDataPointWriter::flushBlock() {
+    string header;
+    appendU32(header, _blockCount);
+    appendU32(header, _block.size());
+    _out.write(header.data(), header.size());
+    _out.write(_block.data(), _block.size());
+    _block.clear();
+    _blockCount = 0;
+}
+
+void BinaryDataPointWriter::close() {
+    if (_blockCount > 0) {
+        flushBlock();
+    }
+    string end;
+    appendU32(end, 0);
+    appendU32(end, 0);
+    _out.write(end.data(), end.size());
+    _out.flush();
+    _closed = true;
+}
+
+BinaryDataPointReader::BinaryDataPointReader(istream& in) : _in(in) {
+    char magic[4];
+    if (!_in.read(magic, 4) || string(magic, 4) != kBinaryMagic) {
+        error("BinaryDataPointReader: stream is not in the binary DataPoint format");
+    }
+    _pos = 0;
+    _remaining = 0;
+    _done = false;
+}
+
+/* HELPER FUNCTION: reads the next block into _block. Returns false at the end marker. */
+bool BinaryDataPointReader::loadBlock() {
+    char header[8];
+    if (!_in.read(header, 8)) {
+        error("BinaryDataPointReader: stream ended without an end marker");
+    }
+    uint32_t count = readU32(header, 0);
+    uint32_t bytes = readU32(header, 4);
+    if (count == 0) {
+        _done = true;
+        return false;
+    }
+    _block.resize(bytes);
+    if (!_in.read(&_block[0], bytes)) {
+        error("BinaryDataPointReader: truncated block");
+    }
+    _pos = 0;
+    _remaining = count;
+    return true;
+}
+
+/*
+ * Decodes one record from the current block, loading the next block when the current
+ * one runs out.
+ */
+bool BinaryDataPointReader::next(DataPoint& point) {
+    if (_done) {
+        return false;
+    }
+    if (_remaining == 0 && !loadBlock()) {
+        return false;
+    }
+    if (_pos + 8 > (int) _block.size()) {
+        error("BinaryDataPointReader: malformed block");
+    }
+    point.priority = (int) readU32(_block.data(), _pos);
+    uint32_t length = readU32(_block.data(), _pos + 4);
+    _pos += 8;
+    if (length > _block.size() - _pos) {
+        error("BinaryDataPointReader: malformed block");
+    }
+    point.name.assign(_block.data() + _pos, length);
+    _pos += length;
+    _remaining--;
+    return true;
+}
+
+void convertTextToBinary(istream& text, ostream& binary) {
+    BinaryDataPointWriter writer(binary);
+    DataPoint point;
+    while (text >> point) {
+        writer.write(point);
+    }
+    writer.close();
+}
+
+/*
+ * Same bounded PQHeap as topK, fed from the binary reader.
+ */
+Vector<DataPoint> topKBinary(istream& binary, int k) {
+    BinaryDataPointReader reader(binary);
+    PQHeap pq;
+    DataPoint point;
+    while (reader.next(point)) {
+        offerTopK(pq, point, k);
+    }
+    return drainDescending(pq);
+}
+
+Vector<DataPoint> pqSortBinary(istream& binary) {
+    BinaryDataPointReader reader(binary);
+    Vector<DataPoint> result;
+    DataPoint point;
+    while (reader.next(point)) {
+        result.add(point);
+    }
+    pqSort(result);
+    return result;
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+/* Helper function that, given a list of data points, produces a binary-format stream from them. */
+static stringstream asBinaryStream(const Vector<DataPoint>& dataPoints, int recordsPerBlock = 4096) {
+    stringstream result;
+    BinaryDataPointWriter writer(result, recordsPerBlock);
+    for (const DataPoint& pt : dataPoints) {
+        writer.write(pt);
+    }
+    writer.close();
+    return result;
+}
+
+STUDENT_TEST("binary format round trip, across block boundaries and with odd names") {
+    Vector<DataPoint> input = { { "A", 1 }, { "", -5 }, { "two words", 2147483647 },
+                                { string("nul\0byte", 8), -2147483647 - 1 }, { "Z", 0 } };
+    for (int perBlock : { 1, 2, 4096 }) {
+        stringstream stream = asBinaryStream(input, perBlock);
+        BinaryDataPointReader reader(stream);
+        Vector<DataPoint> output;
+        DataPoint point;
+        while (reader.next(point)) {
+            output.add(point);
+        }
+        EXPECT_EQUAL(output, input);
+        EXPECT(!reader.next(point));
+    }
+
+    stringstream empty = asBinaryStream({});
+    BinaryDataPointReader reader(empty);
+    DataPoint point;
+    EXPECT(!reader.next(point));
+}
+
+STUDENT_TEST("binary format rejects bad magic and truncated streams") {
+    stringstream text("{ \"A\", 1 }");
+    EXPECT_ERROR(BinaryDataPointReader{ text });
+
+    string bytes = asBinaryStream({ { "A", 1 }, { "B", 2 } }).str();
+    stringstream truncated(bytes.substr(0, bytes.size() - 12));
+    BinaryDataPointReader reader(truncated);
+    DataPoint point;
+    EXPECT_ERROR(reader.next(point));
+}
+
+STUDENT_TEST("convertTextToBinary, topKBinary and pqSortBinary agree with the text versions") {
+    Vector<DataPoint> input;
+    for (int i = 0; i < 10000; i++) {
+        input.add({ "p" + integerToString(i), randomInteger(1, 100000) });
+    }
+    stringstream text;
+    for (const DataPoint& pt : input) {
+        text << pt;
+    }
+    stringstream textCopy(text.str());
+    stringstream binary;
+    convertTextToBinary(text, binary);
+
+    stringstream binaryCopy(binary.str());
+    Vector<DataPoint> expected = topK(textCopy, 10);
+    Vector<DataPoint> result = topKBinary(binary, 10);
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQUAL(result[i].priority, expected[i].priority);
+    }
+
+    Vector<DataPoint> sorted = pqSortBinary(binaryCopy);
+    EXPECT_EQUAL(sorted.size(), input.size());
+    for (int i = 1; i < sorted.size(); i++) {
+        EXPECT(sorted[i - 1].priority <= sorted[i].priority);
+    }
+}
+
+STUDENT_TEST("topK vs topKBinary: time trial, holding k constant and varying n") {
+    int k = 50;
+    for (int n = 400000; n <= 1600000; n *= 2) {
+        Vector<DataPoint> input;
+        for (int i = 0; i < n; i++) {
+            input.add({ "", randomInteger(1, n) });
+        }
+        stringstream text;
+        for (const DataPoint& pt : input) {
+            text << pt;
+        }
+        stringstream binary = asBinaryStream(input);
+        TIME_OPERATION(n, topK(text, k));
+        TIME_OPERATION(n, topKBinary(binary, k));
+    }
+}
@@ -0,0 +1,108 @@
+/* File: dpbinary.h
+ * Assignment brief: compact binary record format for DataPoint streams, so that topK and
+ * pqSort can skip the text operator<< / operator>> round trip.
+ *
+ * Layout (all integers little-endian):
+ *
+ *     stream := "DPB1" block* end
+ *     block  := recordCount:u32 payloadBytes:u32 record{recordCount}
+ *     record := priority:i32 nameLength:u32 nameBytes{nameLength}
+ *     end    := 0:u32 0:u32
+ */
+#pragma once
+#include "testing/MemoryUtils.h"
+#include "datapoint.h"
+#include "vector.h"
+#include <istream>
+#include <ostream>
+#include <string>
+
+/**
+ * Writes DataPoints to an output stream in the binary format. Records are collected
+ * into blocks of recordsPerBlock and each block is written in a single call.
+ */
+class BinaryDataPointWriter {
+public:
+    /**
+     * Creates a writer and writes the stream header to out.
+     */
+    BinaryDataPointWriter(std::ostream& out, int recordsPerBlock = 4096);
+
+    /**
+     * Calls close() if it hasn't been called yet.
+     */
+    ~BinaryDataPointWriter();
+
+    /**
+     * Appends one record. This writes to out only when the current block fills up.
+     */
+    void write(const DataPoint& point);
+
+    /**
+     * Writes any partially filled block, then the end marker. Nothing may be
+     * written after this.
+     */
+    void close();
+
+private:
+    std::ostream& _out;
+    std::string _block;     // encoded records of the current block
+    int _blockCount;        // number of records in _block
+    int _recordsPerBlock;
+    bool _closed;
+
+    void flushBlock();
+
+    DISALLOW_COPYING_OF(BinaryDataPointWriter);
+};
+
+/**
+ * Reads DataPoints back from the binary format, one block at a time.
+ */
+class BinaryDataPointReader {
+public:
+    /**
+     * Creates a reader and checks the stream header.
+     *
+     * Reports an error if in does not start with the binary format's magic number.
+     */
+    BinaryDataPointReader(std::istream& in);
+
+    /**
+     * Reads the next record into point and returns true, or returns false at the end of
+     * the stream. point's name keeps its storage between calls, so reading into the
+     * same DataPoint again and again does not allocate.
+     *
+     * Reports an error if the stream is truncated or a block is malformed.
+     */
+    bool next(DataPoint& point);
+
+private:
+    std::istream& _in;
+    std::string _block;     // payload of the current block
+    int _pos;               // read position in _block
+    int _remaining;         // records left in _block
+    bool _done;
+
+    bool loadBlock();
+
+    DISALLOW_COPYING_OF(BinaryDataPointReader);
+};
+
+/**
+ * Reads text-format DataPoints (as written by operator<<) from text until it runs out,
+ * and writes them to binary in the binary format.
+ */
+void convertTextToBinary(std::istream& text, std::ostream& binary);
+
+/**
+ * Binary-format version of topK. Same behavior as topK(std::istream&, int), but reading
+ * records with a BinaryDataPointReader.
+ */
+Vector<DataPoint> topKBinary(std::istream& binary, int k);
+
+/**
+ * Binary-format version of pqSort: reads every record in binary and returns them sorted
+ * in increasing order of weight.
+ */
+Vector<DataPoint> pqSortBinary(std::istream& binary);
@@ -0,0 +1,315 @@
+/* File: extsort.cpp
+ * Assignment brief: external (out-of-core) merge sort for DataPoint datasets that are
+ * too large to hold in memory as one Vector, built on PQHeap. The header file,
+ * "extsort.h" is in this repository.
+ */
+#include "extsort.h"
+#include "testing/MemoryUtils.h"
+#include "dpbinary.h"
+#include "mergesorted.h"
+#include "pqclient.h"
+#include "pqheap.h"
+#include "vector.h"
+#include "error.h"
+#include "filelib.h"
+#include "random.h"
+#include "strlib.h"
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/*
+ * HELPER CLASS: hands out fresh run file names in options.tempDirectory and removes
+ * every one of them that still exists when it goes out of scope, so a sort that stops
+ * with an error leaves no run files behind. The session number keeps concurrent sorts
+ * in the same directory apart.
+ */
+class RunFiles {
+public:
+    RunFiles(const string& directory) {
+        _directory = directory;
+        _session = randomInteger(0, 999999999);
+    }
+
+    ~RunFiles() {
+        for (const string& path : _paths) {
+            remove(path.c_str());
+        }
+    }
+
+    string create() {
+        string path = _directory + "/extsort_" + integerToString(_session) + "_" +
+                      integerToString(_paths.size()) + ".run";
+        _paths.add(path);
+        return path;
+    }
+
+private:
+    string _directory;
+    int _session;
+    Vector<string> _paths;
+
+    DISALLOW_COPYING_OF(RunFiles);
+};
+
+/* HELPER FUNCTION: opens path for writing a run, reporting an error if that fails. */
+static ofstream openRunForWriting(const string& path) {
+    ofstream out(path, ios::binary);
+    if (!out) {
+        error("externalSort: cannot create temporary file " + path);
+    }
+    return out;
+}
+
+/* HELPER FUNCTION: opens path for reading a run, reporting an error if that fails. */
+static ifstream openRunForReading(const string& path) {
+    ifstream in(path, ios::binary);
+    if (!in) {
+        error("externalSort: cannot open temporary file " + path);
+    }
+    return in;
+}
+
+/* HELPER FUNCTION: replacement selection. Reads all of source and writes sorted runs to
+ * new temporary files, adding their names to runPaths.
+ *
+ * current holds the elements that can still go into the run being written. An input
+ * element smaller than the one just written would break the run's order, so it goes
+ * into next instead. Together the two heaps never hold more than memoryBudget elements.
+ * When current runs dry, the run is finished and next becomes current.
+ */
+static void generateRuns(DataPointSource& source, const ExternalSortOptions& options,
+                         RunFiles& runFiles, Vector<string>& runPaths) {
+    PQHeap heapOne;
+    PQHeap heapTwo;
+    PQHeap* current = &heapOne;
+    PQHeap* next = &heapTwo;
+
+    DataPoint point;
+    while (current->size() < options.memoryBudget && source(point)) {
+        current->enqueue(point);
+    }
+
+    while (!current->isEmpty()) {
+        string path = runFiles.create();
+        runPaths.add(path);
+        ofstream file = openRunForWriting(path);
+        BinaryDataPointWriter writer(file);
+
+        while (!current->isEmpty()) {
+            DataPoint smallest = current->dequeue();
+            writer.write(smallest);
+            if (source(point)) {
+                if (point.priority >= smallest.priority) {
+                    current->enqueue(point);
+                }
+                else {
+                    next->enqueue(point);
+                }
+            }
+        }
+        writer.close();
+
+        PQHeap* temp = current;
+        current = next;
+        next = temp;
+    }
+}
+
+/* HELPER FUNCTION: k-way merge of the given run files into sink, through a
+ * SortedMergeCursor with one binary reader per run. The files and readers live in
+ * deques, which never move an element once it is in.
+ */
+static void mergeRuns(const Vector<string>& paths, DataPointSink& sink) {
+    deque<ifstream> files;
+    deque<BinaryDataPointReader> readers;
+    Vector<DataPointSource> sources;
+    for (const string& path : paths) {
+        files.push_back(openRunForReading(path));
+        readers.emplace_back(files.back());
+        BinaryDataPointReader* reader = &readers.back();
+        sources.add([reader](DataPoint& point) { return reader->next(point); });
+    }
+
+    SortedMergeCursor cursor(sources);
+    DataPoint point;
+    while (cursor.next(point)) {
+        sink(point);
+    }
+}
+
+/*
+ * Forms runs, then merges them fanIn at a time into new runs until at most fanIn are
+ * left. The last merge goes straight to sink. Every temporary file is deleted once it
+ * has been merged, and runFiles deletes any that are left if an error stops the sort.
+ */
+int externalSort(DataPointSource source, DataPointSink sink, const ExternalSortOptions& options) {
+    if (options.memoryBudget < 1 || options.fanIn < 2) {
+        error("externalSort: memoryBudget must be at least 1 and fanIn at least 2");
+    }
+    RunFiles runFiles(options.tempDirectory);
+    Vector<string> runs;
+    generateRuns(source, options, runFiles, runs);
+    int numInitialRuns = runs.size();
+
+    while (runs.size() > options.fanIn) {
+        Vector<string> merged;
+        for (int start = 0; start < runs.size(); start += options.fanIn) {
+            int count = min(options.fanIn, runs.size() - start);
+            Vector<string> group = runs.subList(start, count);
+            string path = runFiles.create();
+            ofstream file = openRunForWriting(path);
+            BinaryDataPointWriter writer(file);
+            DataPointSink toRun = [&](const DataPoint& point) { writer.write(point); };
+            mergeRuns(group, toRun);
+            writer.close();
+            for (const string& done : group) {
+                remove(done.c_str());
+            }
+            merged.add(path);
+        }
+        runs = merged;
+    }
+
+    mergeRuns(runs, sink);
+    for (const string& done : runs) {
+        remove(done.c_str());
+    }
+    return numInitialRuns;
+}
+
+int externalSort(istream& in, ostream& out, const ExternalSortOptions& options) {
+    DataPointSource source = [&](DataPoint& point) { return (bool) (in >> point); };
+    DataPointSink sink = [&](const DataPoint& point) { out << point; };
+    return externalSort(source, sink, options);
+}
+
+int externalSortBinary(istream& in, ostream& out, const ExternalSortOptions& options) {
+    BinaryDataPointReader reader(in);
+    BinaryDataPointWriter writer(out);
+    DataPointSource source = [&](DataPoint& point) { return reader.next(point); };
+    DataPointSink sink = [&](const DataPoint& point) { writer.write(point); };
+    int numRuns = externalSort(source, sink, options);
+    writer.close();
+    return numRuns;
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+/* Helper function that sorts input with externalSort and returns the output and the number of runs. */
+static Vector<DataPoint> sortWith(const Vector<DataPoint>& input, const ExternalSortOptions& options, int& numRuns) {
+    int next = 0;
+    Vector<DataPoint> output;
+    DataPointSource source = [&](DataPoint& point) {
+        if (next == input.size()) return false;
+        point = input[next++];
+        return true;
+    };
+    DataPointSink sink = [&](const DataPoint& point) { output.add(point); };
+    numRuns = externalSort(source, sink, options);
+    return output;
+}
+
+STUDENT_TEST("externalSort matches pqSort, including multi-pass merges") {
+    Vector<DataPoint> input;
+    for (int i = 0; i < 20000; i++) {
+        input.add({ "p" + integerToString(i), randomInteger(-1000, 1000) });
+    }
+    Vector<DataPoint> expected = input;
+    pqSort(expected);
+
+    ExternalSortOptions options;
+    options.memoryBudget = 500;
+    for (int fanIn : { 2, 3, 64 }) {
+        options.fanIn = fanIn;
+        int numRuns;
+        Vector<DataPoint> output = sortWith(input, options, numRuns);
+        EXPECT_EQUAL(output.size(), expected.size());
+        for (int i = 0; i < output.size(); i++) {
+            EXPECT_EQUAL(output[i].priority, expected[i].priority);
+        }
+    }
+}
+
+STUDENT_TEST("externalSort: replacement selection makes runs about twice the memory budget") {
+    ExternalSortOptions options;
+    options.memoryBudget = 1000;
+    int numRuns;
+
+    Vector<DataPoint> random;
+    for (int i = 0; i < 100000; i++) {
+        random.add({ "", randomInteger(1, 1000000) });
+    }
+    sortWith(random, options, numRuns);
+    // 100000 / (2 * 1000) = 50 runs expected; plain load-sort-spill would give 100
+    EXPECT(numRuns >= 45 && numRuns <= 55);
+
+    // already sorted input comes out as a single run, and reverse sorted as n / budget runs
+    Vector<DataPoint> ascending, descending;
+    for (int i = 0; i < 10000; i++) {
+        ascending.add({ "", i });
+        descending.add({ "", -i });
+    }
+    sortWith(ascending, options, numRuns);
+    EXPECT_EQUAL(numRuns, 1);
+    sortWith(descending, options, numRuns);
+    EXPECT_EQUAL(numRuns, 10);
+
+    sortWith({}, options, numRuns);
+    EXPECT_EQUAL(numRuns, 0);
+}
+
+STUDENT_TEST("externalSort text and binary wrappers") {
+    stringstream in;
+    in << DataPoint{ "C", 3 } << DataPoint{ "A", 1 } << DataPoint{ "B", 2 } << DataPoint{ "D", 0 };
+    stringstream inCopy(in.str());
+
+    ExternalSortOptions options;
+    options.memoryBudget = 1;
+    options.fanIn = 2;
+    stringstream out;
+    externalSort(in, out, options);
+    stringstream expected;
+    expected << DataPoint{ "D", 0 } << DataPoint{ "A", 1 } << DataPoint{ "B", 2 } << DataPoint{ "C", 3 };
+    EXPECT_EQUAL(out.str(), expected.str());
+
+    stringstream binaryIn, binaryOut;
+    convertTextToBinary(inCopy, binaryIn);
+    externalSortBinary(binaryIn, binaryOut, options);
+    EXPECT_EQUAL(pqSortBinary(binaryOut), Vector<DataPoint>({ { "D", 0 }, { "A", 1 }, { "B", 2 }, { "C", 3 } }));
+
+    options.fanIn = 1;
+    EXPECT_ERROR(externalSort(in, out, options));
+}
+
+STUDENT_TEST("externalSort leaves no run files behind when the sort stops with an error") {
+    ExternalSortOptions options;
+    options.memoryBudget = 100;
+    options.fanIn = 2;
+    string directory = getTempDirectory() + "/extsort_test_" + integerToString(randomInteger(0, 999999999));
+    createDirectory(directory);
+    options.tempDirectory = directory;
+
+    int next = 0;
+    DataPointSource source = [&](DataPoint& point) {
+        if (next == 5000) return false;
+        point = { "p", randomInteger(-1000, 1000) };
+        next++;
+        return true;
+    };
+    int written = 0;
+    DataPointSink sink = [&](const DataPoint&) {
+        if (++written == 10) error("sink is full");
+    };
+    EXPECT_ERROR(externalSort(source, sink, options));
+    EXPECT(listDirectory(directory).isEmpty());
+
+    options.tempDirectory = directory + "/missing";
+    next = 0;
+    EXPECT_ERROR(externalSort(source, sink, options));
+    deleteFile(directory);
+}
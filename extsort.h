@@ -0,0 +1,50 @@
+/* File: extsort.h
+ * Assignment brief: external (out-of-core) merge sort for DataPoint datasets that are
+ * too large to hold in memory as one Vector, built on PQHeap.
+ */
+#pragma once
+#include "datapoint.h"
+#include "pqclient.h"
+#include <istream>
+#include <ostream>
+#include <string>
+
+/**
+ * Settings for externalSort.
+ */
+struct ExternalSortOptions {
+    int memoryBudget = 1000000;     // most DataPoints held in memory at once while forming runs
+    int fanIn = 64;                 // most runs merged together (one open file per run)
+    std::string tempDirectory = ".";    // where run files are written; they are deleted when done
+};
+
+/**
+ * Sorts every DataPoint produced by source in increasing order of weight, passing them to
+ * sink, while holding at most options.memoryBudget DataPoints in memory.
+ *
+ * Sorted runs are formed with replacement selection: a PQHeap of memoryBudget elements
+ * emits its minimum into the current run and takes in the next input element. Elements
+ * that are smaller than the last one emitted have to wait for the next run, so they
+ * go into a second heap. On random input this makes runs average twice the memory
+ * budget. Runs are spilled to temporary files in the binary DataPoint format. They are
+ * then merged with a heap holding the head of each run, in passes of at most
+ * options.fanIn runs at a time.
+ *
+ * Reports an error if memoryBudget is less than 1, fanIn is less than 2, or a
+ * temporary file cannot be created or opened. Run files are deleted even when an error
+ * stops the sort.
+ *
+ * @return The number of initial sorted runs written to disk.
+ */
+int externalSort(DataPointSource source, DataPointSink sink, const ExternalSortOptions& options = ExternalSortOptions());
+
+/**
+ * Text-format wrapper for externalSort: reads DataPoints from in with operator>> and writes
+ * the sorted output to out with operator<<.
+ */
+int externalSort(std::istream& in, std::ostream& out, const ExternalSortOptions& options = ExternalSortOptions());
+
+/**
+ * Binary-format wrapper for externalSort: reads and writes the format in dpbinary.h.
+ */
+int externalSortBinary(std::istream& in, std::ostream& out, const ExternalSortOptions& options = ExternalSortOptions());
@@ -0,0 +1,335 @@
+/* File: flattree.cpp
+ * Assignment brief: Huffman tree in one array. The header file, "flattree.h" is in this
+ * repository.
+ */
+#include "flattree.h"
+#include "error.h"
+#include "filelib.h"
+#include "strlib.h"
+#include <algorithm>
+#include <cstring>
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/*
+ * All three builders work the same way: the nodes are numbered in preorder into a staging
+ * array on the stack, with a stack of child slots still waiting for a value (slot 2 * node
+ * + side, or -1 for the root). Popping the zero slot before the one slot gives the same
+ * order as the recursive versions.
+ */
+FlatTree::FlatTree(EncodingTreeNode* tree) {
+    if (tree == nullptr || tree->isLeaf()) {
+        error("FlatTree: tree needs at least two leaves");
+    }
+    Node staged[kMaxFlatTreeNodes];
+    struct Pending {
+        EncodingTreeNode* node;
+        int slot;
+    };
+    Pending pending[kMaxFlatTreeNodes + 1];
+    int numPending = 0;
+    int numNodes = 0;
+    pending[numPending++] = { tree, -1 };
+    while (numPending > 0) {
+        Pending next = pending[--numPending];
+        int value;
+        if (next.node->isLeaf()) {
+            value = ~(int) (unsigned char) next.node->ch;
+        }
+        else {
+            if (numNodes == kMaxFlatTreeNodes) {
+                error("FlatTree: tree has more than 256 leaves");
+            }
+            value = numNodes++;
+            pending[numPending++] = { next.node->one, 2 * value + 1 };
+            pending[numPending++] = { next.node->zero, 2 * value };
+        }
+        if (next.slot >= 0) {
+            staged[next.slot / 2].child[next.slot % 2] = value;
+        }
+    }
+    adopt(staged, numNodes);
+}
+
+/*
+ * Internal node i of nodes (numbered numLeaves up to the root) becomes node
+ * numNodes - 1 - i here, which puts the root first and every child after its parent.
+ */
+FlatTree::FlatTree(const HuffmanNodes& nodes) {
+    if (nodes.numLeaves < 2) {
+        error("FlatTree: nodes need at least two leaves");
+    }
+    Node staged[kMaxFlatTreeNodes];
+    auto slotValue = [&](int child) {
+        return (child < nodes.numLeaves) ? ~(int) nodes.symbol[child] : nodes.numNodes - 1 - child;
+    };
+    for (int i = nodes.numLeaves; i < nodes.numNodes; i++) {
+        Node& node = staged[nodes.numNodes - 1 - i];
+        node.child[0] = slotValue(nodes.zero[i]);
+        node.child[1] = slotValue(nodes.one[i]);
+    }
+    adopt(staged, nodes.numNodes - nodes.numLeaves);
+}
+
+FlatTree::FlatTree(Queue<Bit>& treeShape, Queue<char>& treeLeaves) {
+    Node staged[kMaxFlatTreeNodes];
+    int pending[kMaxFlatTreeNodes + 1];
+    int numPending = 0;
+    int numNodes = 0;
+    pending[numPending++] = -1;
+    while (numPending > 0) {
+        int slot = pending[--numPending];
+        if (treeShape.isEmpty()) {
+            error("FlatTree: tree shape ends too soon");
+        }
+        int value;
+        if (treeShape.dequeue() == 0) {
+            if (treeLeaves.isEmpty()) {
+                error("FlatTree: tree leaves end too soon");
+            }
+            value = ~(int) (unsigned char) treeLeaves.dequeue();
+        }
+        else {
+            if (numNodes == kMaxFlatTreeNodes) {
+                error("FlatTree: tree has more than 256 leaves");
+            }
+            value = numNodes++;
+            pending[numPending++] = 2 * value + 1;
+            pending[numPending++] = 2 * value;
+        }
+        if (slot >= 0) {
+            staged[slot / 2].child[slot % 2] = value;
+        }
+    }
+    if (numNodes == 0) {
+        error("FlatTree: tree needs at least two leaves");
+    }
+    adopt(staged, numNodes);
+}
+
+FlatTree::~FlatTree() {
+    delete[] _nodes;
+}
+
+/* HELPER FUNCTION: copies the staged nodes into the tree's one allocation. */
+void FlatTree::adopt(const Node staged[], int numNodes) {
+    _numNodes = numNodes;
+    _nodes = new Node[numNodes];
+    memcpy(_nodes, staged, numNodes * sizeof(Node));
+}
+
+int FlatTree::numLeaves() const {
+    return _numNodes + 1;
+}
+
+string FlatTree::decode(Queue<Bit>& messageBits) const {
+    string msg;
+    int node = 0;
+    while (!messageBits.isEmpty()) {
+        int value = _nodes[node].child[messageBits.dequeue() != 0];
+        if (value < 0) {
+            msg += (char) ~value;
+            node = 0;
+        }
+        else {
+            node = value;
+        }
+    }
+    if (node != 0) {
+        error("FlatTree: message bits end in the middle of a code");
+    }
+    return msg;
+}
+
+/*
+ * Bits are taken 64 at a time into a local word and walked from its high end. A window
+ * can finish at most 64 characters, so the output is grown by 64 before each one and the
+ * loop writes every step's would-be character unconditionally, counting only real ones;
+ * that keeps the leaf test out of the branches.
+ */
+string FlatTree::decode(BitReader& bits) const {
+    string msg;
+    const Node* nodes = _nodes;
+    int node = 0;
+    size_t length = 0;
+    while (bits.remaining() > 0) {
+        int count = min<int64_t>(bits.remaining(), 64);
+        uint64_t window = bits.peek(count) << (64 - count);
+        bits.skip(count);
+        msg.resize(length + 64);
+        char* out = &msg[length];
+        int produced = 0;
+        for (int i = 0; i < count; i++) {
+            int value = nodes[node].child[window >> 63];
+            window <<= 1;
+            out[produced] = (char) ~value;
+            produced += value < 0;
+            node = (value < 0) ? 0 : value;
+        }
+        length += produced;
+    }
+    msg.resize(length);
+    if (node != 0) {
+        error("FlatTree: message bits end in the middle of a code");
+    }
+    return msg;
+}
+
+void FlatTree::flatten(Queue<Bit>& treeShape, Queue<char>& treeLeaves) const {
+    int pending[kMaxFlatTreeNodes + 1];
+    int numPending = 0;
+    pending[numPending++] = 0;
+    while (numPending > 0) {
+        int value = pending[--numPending];
+        if (value < 0) {
+            treeShape.enqueue(0);
+            treeLeaves.enqueue((char) ~value);
+        }
+        else {
+            treeShape.enqueue(1);
+            pending[numPending++] = _nodes[value].child[1];
+            pending[numPending++] = _nodes[value].child[0];
+        }
+    }
+}
+
+string decompressFlat(EncodedData& data) {
+    FlatTree tree(data.treeShape, data.treeLeaves);
+    return tree.decode(data.messageBits);
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * */
+
+STUDENT_TEST("FlatTree: example tree decodes and flattens like the pointer tree") {
+    EncodingTreeNode* tree = createExampleTree();
+    FlatTree flat(tree);
+    EXPECT_EQUAL(flat.numLeaves(), 4);
+    Queue<Bit> messageBits = { 1, 0, 1, 0, 1, 0, 0, 1, 1, 1, 1, 0, 1, 0, 1 }; // STREETS
+    Queue<Bit> copy = messageBits;
+    EXPECT_EQUAL(flat.decode(copy), "STREETS");
+    BitBuffer packed = toBitBuffer(messageBits);
+    BitReader reader(packed);
+    EXPECT_EQUAL(flat.decode(reader), "STREETS");
+    Queue<Bit> cut = { 1, 0, 1, 0, 1, 0, 0, 1, 1, 1, 1, 0, 1, 0 };
+    EXPECT_ERROR(flat.decode(cut));
+
+    Queue<Bit> shape, expectedShape;
+    Queue<char> leaves, expectedLeaves;
+    flat.flatten(shape, leaves);
+    flattenTree(tree, expectedShape, expectedLeaves);
+    EXPECT_EQUAL(shape, expectedShape);
+    EXPECT_EQUAL(leaves, expectedLeaves);
+    deallocateTree(tree);
+
+    EncodingTreeNode* leaf = new EncodingTreeNode('A');
+    EXPECT_ERROR(FlatTree single(leaf));
+    deallocateTree(leaf);
+    Queue<Bit> leafShape = { 0 };
+    Queue<char> leafLeaves = { 'A' };
+    EXPECT_ERROR(FlatTree single(leafShape, leafLeaves));
+    Queue<Bit> shortShape = { 1, 0 };
+    Queue<char> shortLeaves = { 'A', 'B' };
+    EXPECT_ERROR(FlatTree truncated(shortShape, shortLeaves));
+}
+
+STUDENT_TEST("FlatTree: all three builders agree, and decompressFlat matches decompress") {
+    for (string file : { "res/constitution.txt", "res/dream.txt" }) {
+        string text = readEntireFile(file);
+        EncodedData data = compress(text);
+        EncodedData forFlat = data;
+        EXPECT_EQUAL(decompressFlat(forFlat), text);
+
+        EncodingTreeNode* tree = buildHuffmanTreeLinear(text);
+        int64_t counts[256];
+        countBytes(text, counts);
+        HuffmanNodes nodes;
+        buildHuffmanNodes(counts, nodes);
+        FlatTree fromTree(tree);
+        FlatTree fromNodes(nodes);
+        Queue<Bit> treeShape, nodesShape;
+        Queue<char> treeLeaves, nodesLeaves;
+        fromTree.flatten(treeShape, treeLeaves);
+        fromNodes.flatten(nodesShape, nodesLeaves);
+        EXPECT_EQUAL(treeShape, nodesShape);
+        EXPECT_EQUAL(treeLeaves, nodesLeaves);
+        EXPECT_EQUAL(fromNodes.numLeaves(), nodes.numLeaves);
+
+        BitBuffer bits = toBitBuffer(encodeText(tree, text));
+        BitReader reader(bits);
+        EXPECT_EQUAL(fromNodes.decode(reader), text);
+        deallocateTree(tree);
+    }
+}
+
+STUDENT_TEST("FlatTree: 256 leaves in a chain 255 deep, with no recursion") {
+    EncodingTreeNode* tree = new EncodingTreeNode((char) 0);
+    for (int b = 1; b < 256; b++) {
+        tree = new EncodingTreeNode(new EncodingTreeNode((char) b), tree);
+    }
+    FlatTree flat(tree);
+    EXPECT_EQUAL(flat.numLeaves(), 256);
+    string text;
+    for (int b = 0; b < 256; b++) {
+        text += (char) b;
+    }
+    BitBuffer bits = toBitBuffer(encodeText(tree, text));
+    BitReader reader(bits);
+    EXPECT_EQUAL(flat.decode(reader), text);
+
+    EncodingTreeNode* tooBig = new EncodingTreeNode(tree, new EncodingTreeNode('x'));
+    EXPECT_ERROR(FlatTree big(tooBig));
+    deallocateTree(tooBig);
+}
+
+/* Helper functions that decompress every message, one after another, and return the
+ * messages joined together.
+ */
+static string decompressEach(Vector<EncodedData>& messages) {
+    string result;
+    for (EncodedData& data : messages) {
+        result += decompress(data);
+    }
+    return result;
+}
+
+static string decompressEachFlat(Vector<EncodedData>& messages) {
+    string result;
+    for (EncodedData& data : messages) {
+        result += decompressFlat(data);
+    }
+    return result;
+}
+
+STUDENT_TEST("decompress vs decompressFlat on many small messages, and decodeText vs FlatTree") {
+    string base = readEntireFile("res/dream.txt");
+
+    Vector<EncodedData> messages;
+    size_t totalBytes = 0;
+    for (size_t start = 0; start + 200 <= base.size(); start += 200) {
+        messages.add(compress(base.substr(start, 200)));
+        totalBytes += 200;
+    }
+    cout << "    " << messages.size() << " messages of 200 bytes:" << endl;
+    Vector<EncodedData> forTree = messages, forFlat = messages;
+    string fromTree, fromFlat;
+    TIME_OPERATION(totalBytes, fromTree = decompressEach(forTree));
+    TIME_OPERATION(totalBytes, fromFlat = decompressEachFlat(forFlat));
+    EXPECT_EQUAL(fromFlat, fromTree);
+
+    string text;
+    for (int i = 0; i < 32; i++) {
+        text += base;
+    }
+    EncodingTreeNode* tree = buildHuffmanTreeLinear(text);
+    Queue<Bit> messageBits = encodeText(tree, text);
+    BitBuffer bits = toBitBuffer(messageBits);
+    FlatTree flat(tree);
+    cout << "    one message of " << text.size() << " bytes:" << endl;
+    BitReader reader(bits);
+    TIME_OPERATION(text.size(), fromTree = decodeText(tree, messageBits));
+    TIME_OPERATION(text.size(), fromFlat = flat.decode(reader));
+    EXPECT_EQUAL(fromTree, text);
+    EXPECT_EQUAL(fromFlat, text);
+    deallocateTree(tree);
+}
@@ -0,0 +1,99 @@
+/* File: flattree.h
+ * Assignment brief: Huffman tree in one array. unflattenTree and buildHuffmanTree make each
+ * node with its own new, deallocateTree frees them one at a time, and decodeText follows
+ * pointers to nodes scattered over the heap. A FlatTree keeps only the internal nodes,
+ * each as its two child slots side by side, in one array allocated once. A slot holds
+ * either the index of a child node or, for a leaf, its byte value, so leaves take no
+ * space of their own. Building, walking and freeing the tree use loops and fixed-size
+ * stacks instead of recursion.
+ */
+#pragma once
+#include "testing/MemoryUtils.h"
+#include "bitbuffer.h"
+#include "bits.h"
+#include "huffman.h"
+#include "huffmanbuild.h"
+#include "queue.h"
+#include "treenode.h"
+#include <cstdint>
+#include <string>
+
+/**
+ * Most internal nodes a FlatTree can hold: one less than the number of byte values.
+ */
+const int kMaxFlatTreeNodes = 255;
+
+/**
+ * Huffman tree over byte values stored as an array of internal nodes, the root first.
+ * The array is allocated once, at its exact size, and freed by the destructor in one go.
+ */
+class FlatTree {
+public:
+    /**
+     * Builds a flat copy of tree. The tree is not changed and may be freed afterward.
+     * This operation runs in time O(number of tree nodes).
+     *
+     * Reports an error if the tree is a single leaf or has more than 256 leaves.
+     */
+    FlatTree(EncodingTreeNode* tree);
+
+    /**
+     * Builds the tree that buildHuffmanNodes made, with no EncodingTreeNodes in between.
+     *
+     * Reports an error if nodes has fewer than two leaves.
+     */
+    FlatTree(const HuffmanNodes& nodes);
+
+    /**
+     * Same as unflattenTree: rebuilds the tree from the treeShape and treeLeaves made by
+     * flattenTree, consuming them.
+     *
+     * Reports an error if either queue runs out, or they describe a single leaf or more
+     * than 256 leaves.
+     */
+    FlatTree(Queue<Bit>& treeShape, Queue<char>& treeLeaves);
+
+    ~FlatTree();
+
+    /**
+     * Returns the number of leaves.
+     */
+    int numLeaves() const;
+
+    /**
+     * Same as decodeText: decodes and consumes messageBits.
+     *
+     * Reports an error if the bits end in the middle of a code.
+     */
+    std::string decode(Queue<Bit>& messageBits) const;
+
+    /**
+     * Decodes every bit left in bits and returns the message.
+     *
+     * Reports an error if the bits end in the middle of a code.
+     */
+    std::string decode(BitReader& bits) const;
+
+    /**
+     * Same as flattenTree: appends the tree's shape and leaves to the queues.
+     */
+    void flatten(Queue<Bit>& treeShape, Queue<char>& treeLeaves) const;
+
+private:
+    struct Node {
+        int16_t child[2];   // index of an internal node, or ~(byte value) for a leaf
+    };
+
+    Node* _nodes;
+    int _numNodes;
+
+    void adopt(const Node staged[], int numNodes);
+
+    DISALLOW_COPYING_OF(FlatTree);
+};
+
+/**
+ * Drop-in replacement for decompress: rebuilds the tree as a FlatTree and decodes with it,
+ * so the whole message costs one allocation for the tree.
+ */
+std::string decompressFlat(EncodedData& data);
@@ -0,0 +1,217 @@
+/* File: groupedtopk.cpp
+ * Assignment brief: grouped top-k, i.e. the top k priorities for each distinct DataPoint name,
+ * computed in a single pass over the stream. The header file, "groupedtopk.h" is in this
+ * repository.
+ */
+#include "groupedtopk.h"
+#include "pqclient.h"
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <sstream>
+#include "testing/SimpleTest.h"
+using namespace std;
+
+const int INITIAL_GROUP_CAPACITY = 16;
+
+/* HELPER FUNCTION: returns the number of ints in a pool for numGroups groups of k, reporting
+ * an error if that is more than new[] could ever allocate. */
+static size_t poolSize(size_t numGroups, int k) {
+    if (numGroups > (size_t) PTRDIFF_MAX / sizeof(int) / k) {
+        error("GroupedTopK: too many groups for the pool to hold");
+    }
+    return numGroups * k;
+}
+
+GroupedTopK::GroupedTopK(int k) {
+    if (k <= 0) {
+        error("GroupedTopK: k must be positive");
+    }
+    _k = k;
+    _numGroups = 0;
+    _numAllocated = INITIAL_GROUP_CAPACITY;
+    _pool = new int[poolSize(_numAllocated, _k)];
+    _sizes = new int[_numAllocated];
+}
+
+GroupedTopK::~GroupedTopK() {
+    delete[] _pool;
+    delete[] _sizes;
+}
+
+/* HELPER FUNCTION: doubles the pool (and the sizes array) when every group slot is in use. */
+void GroupedTopK::ensureCapacity() {
+    if (_numGroups == _numAllocated) {
+        if (_numAllocated > INT_MAX / 2) {
+            error("GroupedTopK: too many groups for the pool to hold");
+        }
+        int* newPool = new int[poolSize((size_t) _numAllocated * 2, _k)];
+        int* newSizes = new int[(size_t) _numAllocated * 2];
+        copy(_pool, _pool + poolSize(_numGroups, _k), newPool);
+        copy(_sizes, _sizes + _numGroups, newSizes);
+        delete[] _pool;
+        delete[] _sizes;
+        _pool = newPool;
+        _sizes = newSizes;
+        _numAllocated *= 2;
+    }
+}
+
+/* HELPER FUNCTION: 'bubbling up' within one group's heap, starting from index. */
+void GroupedTopK::bubbleUp(int* heap, int index) {
+    while (index > 0 && heap[(index - 1) / 2] > heap[index]) {
+        swap(heap[index], heap[(index - 1) / 2]);
+        index = (index - 1) / 2;
+    }
+}
+
+/* HELPER FUNCTION: 'bubbling down' from the root of one group's heap. */
+void GroupedTopK::bubbleDown(int* heap, int size) {
+    int index = 0;
+    while (2 * index + 1 < size) {
+        int smallerChild = 2 * index + 1;
+        if (smallerChild + 1 < size && heap[smallerChild + 1] < heap[smallerChild]) {
+            smallerChild++;
+        }
+        if (heap[smallerChild] >= heap[index]) {
+            break;
+        }
+        swap(heap[index], heap[smallerChild]);
+        index = smallerChild;
+    }
+}
+
+/*
+ * Finds (or creates) the point's group, then applies the same rule as topK to that
+ * group's heap: add if there is room, otherwise replace the root if point beats it.
+ */
+void GroupedTopK::add(const DataPoint& point) {
+    int group;
+    if (_groupIndex.containsKey(point.name)) {
+        group = _groupIndex[point.name];
+    }
+    else {
+        ensureCapacity();
+        group = _numGroups++;
+        _sizes[group] = 0;
+        _groupIndex[point.name] = group;
+    }
+
+    int* heap = _pool + (size_t) group * _k;
+    int& size = _sizes[group];
+    if (size < _k) {
+        heap[size] = point.priority;
+        size++;
+        bubbleUp(heap, size - 1);
+    }
+    else if (point.priority > heap[0]) {
+        heap[0] = point.priority;
+        bubbleDown(heap, size);
+    }
+}
+
+Vector<DataPoint> GroupedTopK::resultsFor(const string& name) const {
+    if (!_groupIndex.containsKey(name)) {
+        return {};
+    }
+    int group = _groupIndex.get(name);
+    int* heap = _pool + (size_t) group * _k;
+    Vector<int> priorities;
+    for (int i = 0; i < _sizes[group]; i++) {
+        priorities.add(heap[i]);
+    }
+    sort(priorities.begin(), priorities.end(), greater<int>());
+
+    Vector<DataPoint> result;
+    for (int priority : priorities) {
+        result.add({ name, priority });
+    }
+    return result;
+}
+
+Map<string, Vector<DataPoint>> GroupedTopK::results() const {
+    Map<string, Vector<DataPoint>> result;
+    for (const string& name : _groupIndex) {
+        result[name] = resultsFor(name);
+    }
+    return result;
+}
+
+int GroupedTopK::numGroups() const {
+    return _numGroups;
+}
+
+Map<string, Vector<DataPoint>> groupedTopK(istream& stream, int k) {
+    GroupedTopK groups(k);
+    DataPoint point;
+    while (stream >> point) {
+        groups.add(point);
+    }
+    return groups.results();
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+/* Helper function that makes n points spread over numNames names. */
+static Vector<DataPoint> randomGroupedPoints(int n, int numNames) {
+    Vector<DataPoint> points;
+    for (int i = 0; i < n; i++) {
+        points.add({ "g" + integerToString(randomInteger(0, numNames - 1)), randomInteger(-1000, 1000) });
+    }
+    return points;
+}
+
+STUDENT_TEST("groupedTopK on a small hand-constructed input") {
+    stringstream stream;
+    Vector<DataPoint> input = { { "A", 1 }, { "B", 7 }, { "A", 5 }, { "A", 3 }, { "B", 2 }, { "C", 4 } };
+    for (const DataPoint& pt : input) {
+        stream << pt;
+    }
+    Map<string, Vector<DataPoint>> result = groupedTopK(stream, 2);
+    EXPECT_EQUAL(result.size(), 3);
+    EXPECT_EQUAL(result["A"], Vector<DataPoint>({ { "A", 5 }, { "A", 3 } }));
+    EXPECT_EQUAL(result["B"], Vector<DataPoint>({ { "B", 7 }, { "B", 2 } }));
+    EXPECT_EQUAL(result["C"], Vector<DataPoint>({ { "C", 4 } }));
+    EXPECT_ERROR(GroupedTopK(0));
+}
+
+STUDENT_TEST("GroupedTopK matches one topK call per group, across pool growth") {
+    Vector<DataPoint> points = randomGroupedPoints(50000, 1000);
+    GroupedTopK groups(5);
+    Map<string, Vector<DataPoint>> byName;
+    for (const DataPoint& pt : points) {
+        groups.add(pt);
+        byName[pt.name].add(pt);
+    }
+    EXPECT_EQUAL(groups.numGroups(), byName.size());
+    for (const string& name : byName) {
+        Vector<DataPoint> expected = topK(byName[name], 5);
+        Vector<DataPoint> result = groups.resultsFor(name);
+        EXPECT_EQUAL(result.size(), expected.size());
+        for (int i = 0; i < result.size(); i++) {
+            EXPECT_EQUAL(result[i].priority, expected[i].priority);
+        }
+    }
+    EXPECT_EQUAL(groups.resultsFor("missing"), Vector<DataPoint>());
+}
+
+/* Helper function for the time trial below. */
+static void addAll(GroupedTopK& groups, const Vector<DataPoint>& points) {
+    for (const DataPoint& pt : points) {
+        groups.add(pt);
+    }
+}
+
+STUDENT_TEST("GroupedTopK time trial, holding n constant and varying the number of groups") {
+    int n = 400000;
+    for (int numNames = 1000; numNames <= 100000; numNames *= 10) {
+        Vector<DataPoint> points = randomGroupedPoints(n, numNames);
+        GroupedTopK groups(3);
+        TIME_OPERATION(numNames, addAll(groups, points));
+    }
+}
@@ -0,0 +1,80 @@
+/* File: groupedtopk.h
+ * Assignment brief: grouped top-k, i.e. the top k priorities for each distinct DataPoint name,
+ * computed in a single pass over the stream.
+ */
+#pragma once
+#include "testing/MemoryUtils.h"
+#include "datapoint.h"
+#include "hashmap.h"
+#include "map.h"
+#include "vector.h"
+#include <istream>
+#include <string>
+
+/**
+ * Keeps the k highest priorities for every distinct name seen so far.
+ *
+ * Each group is a bounded min-heap of at most k priorities, the same shape as the heap
+ * that topK uses. The name is the group's key, so only priorities are stored. Group
+ * heaps are not separate objects: they are fixed-size slices of one shared pool array,
+ * so adding a new group costs no allocation of its own. The pool grows by doubling,
+ * like PQHeap's array, so the number of allocations is logarithmic in the number of
+ * groups.
+ */
+class GroupedTopK {
+public:
+    /**
+     * Creates an empty grouping that keeps the top k priorities per name.
+     *
+     * Reports an error if k is not positive.
+     */
+    GroupedTopK(int k);
+
+    /**
+     * Cleans up the pool.
+     */
+    ~GroupedTopK();
+
+    /**
+     * Offers point to the group for point.name. This operation runs in time O(log k),
+     * plus one hash lookup.
+     */
+    void add(const DataPoint& point);
+
+    /**
+     * Returns the top k DataPoints of the group for name, in descending order of weight.
+     * Returns an empty Vector if no point with that name has been added.
+     */
+    Vector<DataPoint> resultsFor(const std::string& name) const;
+
+    /**
+     * Returns the top k DataPoints of every group, in descending order of weight, keyed
+     * by name.
+     */
+    Map<std::string, Vector<DataPoint>> results() const;
+
+    /**
+     * Returns the number of distinct names seen so far.
+     */
+    int numGroups() const;
+
+private:
+    int _k;
+    HashMap<std::string, int> _groupIndex;  // name -> group number
+    int* _pool;             // group g's heap lives in _pool[g * _k] through _pool[g * _k + _k - 1]
+    int* _sizes;            // number of filled slots in each group's heap
+    int _numGroups;         // number of groups in use
+    int _numAllocated;      // number of groups the pool has room for
+
+    void ensureCapacity();
+    void bubbleUp(int* heap, int index);
+    void bubbleDown(int* heap, int size);
+
+    DISALLOW_COPYING_OF(GroupedTopK);
+};
+
+/**
+ * Given a stream of DataPoints, returns the top k DataPoints for each distinct name, in
+ * descending order of weight, keyed by name. The stream is read once.
+ */
+Map<std::string, Vector<DataPoint>> groupedTopK(std::istream& stream, int k);
@@ -0,0 +1,255 @@
+/* File: heavyhitters.cpp
+ * Assignment brief: approximate heavy hitters (most frequent DataPoint names in a stream)
+ * using a Count-Min sketch paired with a size-k PQHeap of candidates. The header file,
+ * "heavyhitters.h" is in this repository.
+ */
+#include "heavyhitters.h"
+#include "pqclient.h"
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/* HELPER FUNCTION: 64-bit FNV-1a hash of the bytes of key. The low and high halves
+ * are used as the two hashes for double hashing across the rows of the sketch.
+ */
+static uint64_t hashKey(const string& key) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (char ch : key) {
+        hash ^= (unsigned char) ch;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/*
+ * The constructor sizes the counter table from the error bounds and zeroes it.
+ * This is the only allocation the sketch ever makes.
+ */
+CountMinSketch::CountMinSketch(double epsilon, double delta) {
+    if (epsilon <= 0 || epsilon >= 1 || delta <= 0 || delta >= 1) {
+        error("CountMinSketch: epsilon and delta must be between 0 and 1");
+    }
+    double width = ceil(exp(1.0) / epsilon);
+    double depth = ceil(log(1.0 / delta));
+    if (width > INT_MAX || width * depth > (double) (PTRDIFF_MAX / sizeof(int))) {
+        error("CountMinSketch: epsilon and delta need a table too large to allocate");
+    }
+    _width = (int) width;
+    _depth = (int) depth;
+    _table = new int[(size_t) _width * _depth]();
+}
+
+CountMinSketch::~CountMinSketch() {
+    delete[] _table;
+}
+
+/*
+ * Adds count to one counter in each row. Counters saturate at INT_MAX instead of
+ * overflowing, so an estimate stays an upper bound even on very long streams.
+ */
+void CountMinSketch::add(const string& key, int count) {
+    uint64_t hash = hashKey(key);
+    uint32_t h1 = (uint32_t) hash;
+    uint32_t h2 = (uint32_t) (hash >> 32) | 1;
+    for (int row = 0; row < _depth; row++) {
+        int& counter = _table[(size_t) row * _width + (h1 + row * h2) % _width];
+        counter = (counter > INT_MAX - count) ? INT_MAX : counter + count;
+    }
+}
+
+/*
+ * Every row overcounts (other keys may share the counter), so the smallest
+ * counter across the rows is the best estimate.
+ */
+int CountMinSketch::estimate(const string& key) const {
+    uint64_t hash = hashKey(key);
+    uint32_t h1 = (uint32_t) hash;
+    uint32_t h2 = (uint32_t) (hash >> 32) | 1;
+    int result = INT_MAX;
+    for (int row = 0; row < _depth; row++) {
+        result = min(result, _table[(size_t) row * _width + (h1 + row * h2) % _width]);
+    }
+    return result;
+}
+
+int CountMinSketch::width() const {
+    return _width;
+}
+
+int CountMinSketch::depth() const {
+    return _depth;
+}
+
+HeavyHitters::HeavyHitters(int k, double epsilon, double delta) : _sketch(epsilon, delta) {
+    if (k <= 0) {
+        error("HeavyHitters: k must be positive");
+    }
+    _k = k;
+}
+
+/* HELPER FUNCTION: the heap holds exactly one entry per candidate, but an entry's
+ * priority is the count from when it was enqueued. Counts only grow, so a stale entry
+ * is an underestimate. Re-enqueue stale entries at the top until the top is current,
+ * so that peek() gives the true smallest candidate.
+ */
+void HeavyHitters::refreshMin() {
+    while (_candidates.peek().priority != _counts[_candidates.peek().name]) {
+        DataPoint stale = _candidates.dequeue();
+        stale.priority = _counts[stale.name];
+        _candidates.enqueue(stale);
+    }
+}
+
+/*
+ * This function counts name in the sketch and then decides whether name belongs in the
+ * candidate set. A name already in the set just has its count updated. Otherwise it
+ * fills an open slot, or replaces the smallest candidate if its estimate is larger.
+ */
+void HeavyHitters::add(const string& name) {
+    _sketch.add(name);
+    int estimate = _sketch.estimate(name);
+
+    if (_counts.containsKey(name)) {
+        _counts[name] = estimate;
+    }
+    else if (_candidates.size() < _k) {
+        _counts[name] = estimate;
+        _candidates.enqueue({ name, estimate });
+    }
+    else {
+        refreshMin();
+        if (estimate > _candidates.peek().priority) {
+            _counts.remove(_candidates.dequeue().name);
+            _counts[name] = estimate;
+            _candidates.enqueue({ name, estimate });
+        }
+    }
+}
+
+/*
+ * The candidates are copied into a scratch PQHeap and drained, which gives them in
+ * descending order of estimated count.
+ */
+Vector<DataPoint> HeavyHitters::topK() const {
+    PQHeap pq;
+    for (const string& name : _counts) {
+        pq.enqueue({ name, _counts.get(name) });
+    }
+    return drainDescending(pq);
+}
+
+/*
+ * Feeds the name of every DataPoint in the stream into a HeavyHitters tracker.
+ */
+Vector<DataPoint> topKFrequent(istream& stream, int k, double epsilon, double delta) {
+    HeavyHitters tracker(k, epsilon, delta);
+    DataPoint point;
+    while (stream >> point) {
+        tracker.add(point.name);
+    }
+    return tracker.topK();
+}
+
+/*
+ * Counts every distinct name exactly, then keeps the k largest counts with a
+ * bounded PQHeap in the same way as topK.
+ */
+Vector<DataPoint> topKFrequentExact(istream& stream, int k) {
+    HashMap<string, int> counts;
+    DataPoint point;
+    while (stream >> point) {
+        counts[point.name]++;
+    }
+
+    PQHeap pq;
+    for (const string& name : counts) {
+        offerTopK(pq, DataPoint{ name, counts[name] }, k);
+    }
+    return drainDescending(pq);
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+/* Helper function that builds a stream where name "hot<i>" appears (i + 1) * hotRepeats
+ * times, mixed in with numNoise names that each appear once.
+ */
+static stringstream skewedStream(int numHot, int hotRepeats, int numNoise) {
+    Vector<DataPoint> points;
+    for (int i = 0; i < numHot; i++) {
+        for (int j = 0; j < (i + 1) * hotRepeats; j++) {
+            points.add({ "hot" + integerToString(i), 0 });
+        }
+    }
+    for (int i = 0; i < numNoise; i++) {
+        points.add({ "noise" + integerToString(i), 0 });
+    }
+    // shuffle so hot names are spread through the stream
+    for (int i = points.size() - 1; i > 0; i--) {
+        int j = randomInteger(0, i);
+        DataPoint temp = points[i];
+        points[i] = points[j];
+        points[j] = temp;
+    }
+    stringstream result;
+    for (const DataPoint& pt : points) {
+        result << pt;
+    }
+    return result;
+}
+
+STUDENT_TEST("CountMinSketch never underestimates, and sizes itself from the error bounds") {
+    CountMinSketch sketch(0.01, 0.01);
+    EXPECT_EQUAL(sketch.width(), 272);
+    EXPECT_EQUAL(sketch.depth(), 5);
+
+    for (int i = 0; i < 2000; i++) {
+        sketch.add("key" + integerToString(i % 100), 1);
+    }
+    for (int i = 0; i < 100; i++) {
+        int estimate = sketch.estimate("key" + integerToString(i));
+        EXPECT(estimate >= 20);
+        EXPECT(estimate <= 20 + 0.01 * 2000);
+    }
+    EXPECT_ERROR(CountMinSketch(0, 0.5));
+    EXPECT_ERROR(CountMinSketch(1e-300, 0.5));
+}
+
+STUDENT_TEST("HeavyHitters finds the hot names in order among many one-off names") {
+    stringstream stream = skewedStream(5, 200, 20000);
+    Vector<DataPoint> result = topKFrequent(stream, 5, 0.001, 0.001);
+    EXPECT_EQUAL(result.size(), 5);
+    for (int i = 0; i < 5; i++) {
+        EXPECT_EQUAL(result[i].name, "hot" + integerToString(4 - i));
+        EXPECT(result[i].priority >= (5 - i) * 200);
+    }
+}
+
+STUDENT_TEST("HeavyHitters agrees with exact counting, and handles k larger than the number of names") {
+    stringstream stream = skewedStream(10, 50, 5000);
+    stringstream copy(stream.str());
+    Vector<DataPoint> approx = topKFrequent(stream, 3);
+    Vector<DataPoint> exact = topKFrequentExact(copy, 3);
+    EXPECT_EQUAL(approx, exact);
+
+    stream = skewedStream(2, 3, 0);
+    Vector<DataPoint> expected = { { "hot1", 6 }, { "hot0", 3 } };
+    EXPECT_EQUAL(topKFrequent(stream, 10), expected);
+    EXPECT_ERROR(HeavyHitters(0, 0.01, 0.01));
+}
+
+STUDENT_TEST("topKFrequent vs topKFrequentExact: time trial, varying the number of distinct names") {
+    // the sketch uses the same memory at every size; the exact map grows with every distinct name
+    for (int numNoise = 100000; numNoise <= 400000; numNoise *= 2) {
+        stringstream stream = skewedStream(20, 100, numNoise);
+        stringstream copy(stream.str());
+        TIME_OPERATION(numNoise, topKFrequent(stream, 20));
+        TIME_OPERATION(numNoise, topKFrequentExact(copy, 20));
+    }
+}
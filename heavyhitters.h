@@ -0,0 +1,111 @@
+/* File: heavyhitters.h
+ * Assignment brief: approximate heavy hitters (most frequent DataPoint names in a stream)
+ * using a Count-Min sketch paired with a size-k PQHeap of candidates.
+ */
+#pragma once
+#include "testing/MemoryUtils.h"
+#include "datapoint.h"
+#include "hashmap.h"
+#include "pqheap.h"
+#include "vector.h"
+#include <istream>
+#include <string>
+
+/**
+ * Count-Min sketch: a fixed-size table of counters that estimates how many times
+ * each key has been added. Estimates never undercount. With probability at least
+ * 1 - delta, an estimate overcounts by at most epsilon * (total number of adds).
+ */
+class CountMinSketch {
+public:
+    /**
+     * Creates a sketch sized for the given error bounds. The table has
+     * ceil(e / epsilon) columns and ceil(ln(1 / delta)) rows, no matter how many
+     * distinct keys are added later.
+     *
+     * Reports an error if epsilon or delta is not strictly between 0 and 1, or if the
+     * table they call for is too large to allocate.
+     */
+    CountMinSketch(double epsilon, double delta);
+
+    /**
+     * Cleans up the counter table.
+     */
+    ~CountMinSketch();
+
+    /**
+     * Adds count occurrences of key. This operation runs in time O(depth).
+     */
+    void add(const std::string& key, int count = 1);
+
+    /**
+     * Returns the estimated number of occurrences of key. This operation runs in time O(depth).
+     */
+    int estimate(const std::string& key) const;
+
+    /**
+     * Returns the number of columns / rows in the counter table.
+     */
+    int width() const;
+    int depth() const;
+
+private:
+    int* _table;    // depth rows of width counters, stored row after row
+    int _width;
+    int _depth;
+
+    DISALLOW_COPYING_OF(CountMinSketch);
+};
+
+/**
+ * Tracks the (approximately) k most frequent names seen so far, using O(k) memory
+ * for candidates plus the fixed memory of a Count-Min sketch.
+ */
+class HeavyHitters {
+public:
+    /**
+     * Creates a tracker for the top k names. epsilon and delta are passed on to
+     * the underlying CountMinSketch.
+     *
+     * Reports an error if k is not positive.
+     */
+    HeavyHitters(int k, double epsilon, double delta);
+
+    /**
+     * Records one occurrence of name. This operation runs in time O(depth + log k)
+     * amortized.
+     */
+    void add(const std::string& name);
+
+    /**
+     * Returns the current candidates as DataPoints whose priority is the estimated
+     * count, sorted in descending order of estimated count.
+     */
+    Vector<DataPoint> topK() const;
+
+private:
+    int _k;
+    CountMinSketch _sketch;
+    PQHeap _candidates;             // min-heap of candidates, priority = count when last enqueued
+    HashMap<std::string, int> _counts;  // latest estimated count of each candidate
+
+    void refreshMin();
+
+    DISALLOW_COPYING_OF(HeavyHitters);
+};
+
+/**
+ * Given a stream of DataPoints, returns the (approximately) k most frequent names in the
+ * stream. Each result has the name as its name and the estimated number of occurrences
+ * as its priority, sorted in descending order of priority.
+ *
+ * Memory use is fixed by k, epsilon and delta, and does not depend on how many
+ * distinct names are in the stream.
+ */
+Vector<DataPoint> topKFrequent(std::istream& stream, int k, double epsilon = 0.0001, double delta = 0.001);
+
+/**
+ * Exact version of topKFrequent that keeps a count for every distinct name. Memory
+ * use is O(number of distinct names). Used as the baseline in benchmarks.
+ */
+Vector<DataPoint> topKFrequentExact(std::istream& stream, int k);
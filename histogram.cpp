@@ -0,0 +1,164 @@
+/* File: histogram.cpp
+ * Assignment brief: fast byte histogram for Huffman frequency counting. The header file,
+ * "histogram.h" is in this repository.
+ */
+#include "histogram.h"
+#include "huffmanbuild.h"
+#include "map.h"
+#include "error.h"
+#include "strlib.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/* 32-bit tables stay small enough to sit in L1 cache; a chunk this size can't overflow them. */
+const size_t kHistogramChunkBytes = 1 << 30;
+
+/* HELPER FUNCTION: adds the byte counts of data[0 .. size) to counts, size at most
+ * kHistogramChunkBytes. Eight bytes are loaded at once and dealt out to the four tables
+ * in turn.
+ */
+static void histogramChunk(const unsigned char* data, size_t size, int64_t counts[256]) {
+    uint32_t tables[4][256];
+    memset(tables, 0, sizeof(tables));
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        tables[0][word & 0xFF]++;
+        tables[1][(word >> 8) & 0xFF]++;
+        tables[2][(word >> 16) & 0xFF]++;
+        tables[3][(word >> 24) & 0xFF]++;
+        tables[0][(word >> 32) & 0xFF]++;
+        tables[1][(word >> 40) & 0xFF]++;
+        tables[2][(word >> 48) & 0xFF]++;
+        tables[3][word >> 56]++;
+    }
+    for (; i < size; i++) {
+        tables[0][data[i]]++;
+    }
+
+    for (int b = 0; b < 256; b++) {
+        counts[b] += (int64_t) tables[0][b] + tables[1][b] + tables[2][b] + tables[3][b];
+    }
+}
+
+void histogram(const char* data, size_t size, int64_t counts[256]) {
+    for (int b = 0; b < 256; b++) {
+        counts[b] = 0;
+    }
+    const unsigned char* bytes = (const unsigned char*) data;
+    for (size_t start = 0; start < size; start += kHistogramChunkBytes) {
+        histogramChunk(bytes + start, min(kHistogramChunkBytes, size - start), counts);
+    }
+}
+
+/*
+ * Each thread writes only its own row of partial, so the threads share nothing until
+ * they are joined and the rows are added up.
+ */
+void histogramParallel(const char* data, size_t size, int64_t counts[256], int numThreads) {
+    if (numThreads <= 0) {
+        numThreads = max(1u, thread::hardware_concurrency());
+    }
+    numThreads = (int) min((size_t) numThreads, max((size_t) 1, size / kParallelHistogramMinBytes));
+    if (numThreads == 1) {
+        histogram(data, size, counts);
+        return;
+    }
+
+    vector<int64_t> partial(numThreads * 256);
+    vector<thread> threads;
+    size_t slice = size / numThreads;
+    for (int t = 0; t < numThreads; t++) {
+        size_t start = t * slice;
+        size_t length = (t == numThreads - 1) ? size - start : slice;
+        threads.emplace_back(histogram, data + start, length, &partial[t * 256]);
+    }
+    for (thread& worker : threads) {
+        worker.join();
+    }
+
+    for (int b = 0; b < 256; b++) {
+        counts[b] = 0;
+        for (int t = 0; t < numThreads; t++) {
+            counts[b] += partial[t * 256 + b];
+        }
+    }
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * */
+
+/* Helper that counts one byte at a time into a single table, for comparison. */
+static void histogramSimple(const string& text, int64_t counts[256]) {
+    for (int b = 0; b < 256; b++) {
+        counts[b] = 0;
+    }
+    for (char ch : text) {
+        counts[(unsigned char) ch]++;
+    }
+}
+
+/* Helper that counts into a Map the way buildHuffmanTree does, for comparison. */
+static Map<char, int> histogramMap(const string& text) {
+    Map<char, int> freq;
+    for (char ch : text) {
+        freq[ch] += 1;
+    }
+    return freq;
+}
+
+STUDENT_TEST("histogram and histogramParallel agree with a simple count") {
+    string text;
+    for (int i = 0; i < 3000003; i++) {
+        text += (char) (i % 5 == 0 ? randomInteger(0, 255) : 'e');
+    }
+    int64_t expected[256];
+    histogramSimple(text, expected);
+
+    for (size_t length : { (size_t) 0, (size_t) 1, (size_t) 7, (size_t) 8, (size_t) 9, (size_t) 1000, text.size() }) {
+        int64_t prefix[256];
+        histogramSimple(text.substr(0, length), prefix);
+        int64_t counts[256];
+        histogram(text.data(), length, counts);
+        for (int b = 0; b < 256; b++) {
+            EXPECT_EQUAL(counts[b], prefix[b]);
+        }
+    }
+    for (int threads : { 0, 1, 2, 3, 8 }) {
+        int64_t counts[256];
+        histogramParallel(text.data(), text.size(), counts, threads);
+        for (int b = 0; b < 256; b++) {
+            EXPECT_EQUAL(counts[b], expected[b]);
+        }
+    }
+    int64_t counts[256];
+    countBytes(text, counts);
+    EXPECT_EQUAL(counts[(unsigned char) 'e'], expected[(unsigned char) 'e']);
+}
+
+STUDENT_TEST("histogram throughput: Map, single table, interleaved tables, threads") {
+    const size_t size = 64 << 20;
+    string random(size, '\0');
+    for (size_t i = 0; i < size; i++) {
+        random[i] = (char) randomInteger(0, 255);
+    }
+    string runs(size, 'x');
+
+    for (const string* input : { &random, &runs }) {
+        cout << "    " << (input == &random ? "random bytes" : "one repeated byte") << ":" << endl;
+        int64_t counts[256];
+        string slice = input->substr(0, size / 16);
+        TIME_OPERATION(slice.size(), histogramMap(slice));
+        TIME_OPERATION(size, histogramSimple(*input, counts));
+        TIME_OPERATION(size, histogram(input->data(), size, counts));
+        TIME_OPERATION(size, histogramParallel(input->data(), size, counts));
+        EXPECT_EQUAL(counts[(unsigned char) (*input)[0]] > 0, true);
+    }
+}
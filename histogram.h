@@ -0,0 +1,30 @@
+/* File: histogram.h
+ * Assignment brief: fast byte histogram for Huffman frequency counting. The first pass of
+ * buildHuffmanTree counts into a Map<char, int>; this counts into flat arrays instead.
+ * A run of equal bytes makes a single count table slow, because every increment has
+ * to wait for the store of the previous one to the same slot. Here consecutive bytes
+ * go to four separate tables that are added up at the end, so neighbouring increments
+ * never touch the same memory.
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Inputs smaller than this per thread are counted on the calling thread only, since
+ * starting a thread costs more than counting them.
+ */
+const size_t kParallelHistogramMinBytes = 1 << 20;
+
+/**
+ * Fills counts[b] with the number of times byte value b occurs in data[0 .. size).
+ */
+void histogram(const char* data, size_t size, int64_t counts[256]);
+
+/**
+ * Same result as histogram, with the input split into numThreads slices that are counted
+ * on their own threads (numThreads = 0 means one per hardware thread). The per-thread
+ * histograms are added up at the end. Uses fewer threads when there is less than
+ * kParallelHistogramMinBytes of input per thread.
+ */
+void histogramParallel(const char* data, size_t size, int64_t counts[256], int numThreads = 0);
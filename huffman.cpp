@@ -55,7 +55,10 @@ EncodingTreeNode* unflattenTree(Queue<Bit>& treeShape, Queue<char>& treeLeaves)
         node = new EncodingTreeNode(treeLeaves.dequeue());
     }
     else { // if treeShape.dequeue() == 1
-        node = new EncodingTreeNode(unflattenTree(treeShape, treeLeaves), unflattenTree(treeShape, treeLeaves));
+        // build the zero subtree first: the order function arguments are evaluated in is unspecified
+        EncodingTreeNode* zero = unflattenTree(treeShape, treeLeaves);
+        EncodingTreeNode* one = unflattenTree(treeShape, treeLeaves);
+        node = new EncodingTreeNode(zero, one);
     }
     return node;
 }
@@ -0,0 +1,173 @@
+/* File: huffmanbuild.cpp
+ * Assignment brief: linear-time Huffman tree construction. The header file, "huffmanbuild.h"
+ * is in this repository.
+ */
+#include "huffmanbuild.h"
+#include "huffman.h"
+#include "histogram.h"
+#include "error.h"
+#include "filelib.h"
+#include "strlib.h"
+#include <algorithm>
+#include "testing/SimpleTest.h"
+using namespace std;
+
+void countBytes(const string& text, int64_t counts[256]) {
+    histogram(text.data(), text.size(), counts);
+}
+
+/*
+ * Both queues are plain ranges of node numbers: the leaves are 0 .. numLeaves-1 and the
+ * merged nodes are numLeaves .. numNodes-1, so each queue is just a "next" index.
+ */
+void buildHuffmanNodes(const int64_t counts[256], HuffmanNodes& nodes) {
+    int order[256];
+    int numLeaves = 0;
+    for (int b = 0; b < 256; b++) {
+        if (counts[b] > 0) {
+            order[numLeaves++] = b;
+        }
+    }
+    stable_sort(order, order + numLeaves, [&](int a, int b) {
+        return counts[a] < counts[b];
+    });
+
+    for (int i = 0; i < numLeaves; i++) {
+        nodes.weight[i] = counts[order[i]];
+        nodes.zero[i] = -1;
+        nodes.one[i] = -1;
+        nodes.symbol[i] = order[i];
+    }
+    nodes.numLeaves = numLeaves;
+    nodes.numNodes = numLeaves;
+
+    int nextLeaf = 0;
+    int nextMerged = numLeaves;
+    auto takeLightest = [&]() {
+        if (nextLeaf < numLeaves &&
+                (nextMerged == nodes.numNodes || nodes.weight[nextLeaf] <= nodes.weight[nextMerged])) {
+            return nextLeaf++;
+        }
+        return nextMerged++;
+    };
+    for (int merges = 0; merges < numLeaves - 1; merges++) {
+        int zero = takeLightest();
+        int one = takeLightest();
+        int node = nodes.numNodes++;
+        nodes.weight[node] = nodes.weight[zero] + nodes.weight[one];
+        nodes.zero[node] = zero;
+        nodes.one[node] = one;
+    }
+}
+
+/*
+ * Children come before parents in nodes, so creating the EncodingTreeNodes in node order
+ * always finds both children already made.
+ */
+EncodingTreeNode* buildHuffmanTreeLinear(const string& text) {
+    int64_t counts[256];
+    countBytes(text, counts);
+    HuffmanNodes nodes;
+    buildHuffmanNodes(counts, nodes);
+    if (nodes.numLeaves < 2) {
+        error("need input text with at least 2 distinct chars");
+    }
+
+    EncodingTreeNode* made[511];
+    for (int i = 0; i < nodes.numNodes; i++) {
+        if (nodes.zero[i] == -1) {
+            made[i] = new EncodingTreeNode((char) nodes.symbol[i]);
+        }
+        else {
+            made[i] = new EncodingTreeNode(made[nodes.zero[i]], made[nodes.one[i]]);
+        }
+    }
+    return made[nodes.numNodes - 1];
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * */
+
+/* Helper function that adds up depth * count over the leaves below node. */
+static int64_t weightedDepth(EncodingTreeNode* node, int depth, const int64_t counts[256]) {
+    if (node->isLeaf()) {
+        return depth * counts[(unsigned char) node->ch];
+    }
+    return weightedDepth(node->zero, depth + 1, counts) + weightedDepth(node->one, depth + 1, counts);
+}
+
+/* Helper function that returns the total number of bits tree takes to encode text. */
+static int64_t encodedBits(EncodingTreeNode* tree, const string& text) {
+    int64_t counts[256];
+    countBytes(text, counts);
+    return weightedDepth(tree, 0, counts);
+}
+
+STUDENT_TEST("buildHuffmanNodes: weights in the nodes, children before parents") {
+    int64_t counts[256] = { 0 };
+    counts['a'] = 5;
+    counts['b'] = 1;
+    counts['c'] = 1;
+    counts['d'] = 3;
+    HuffmanNodes nodes;
+    buildHuffmanNodes(counts, nodes);
+    EXPECT_EQUAL(nodes.numLeaves, 4);
+    EXPECT_EQUAL(nodes.numNodes, 7);
+    EXPECT_EQUAL(nodes.symbol[0], 'b');
+    EXPECT_EQUAL(nodes.symbol[1], 'c');
+    EXPECT_EQUAL(nodes.symbol[3], 'a');
+    EXPECT_EQUAL(nodes.weight[6], 10);
+    for (int i = nodes.numLeaves; i < nodes.numNodes; i++) {
+        EXPECT(nodes.zero[i] < i && nodes.one[i] < i);
+        EXPECT_EQUAL(nodes.weight[i], nodes.weight[nodes.zero[i]] + nodes.weight[nodes.one[i]]);
+    }
+
+    int64_t none[256] = { 0 };
+    buildHuffmanNodes(none, nodes);
+    EXPECT_EQUAL(nodes.numNodes, 0);
+    none['x'] = 4;
+    buildHuffmanNodes(none, nodes);
+    EXPECT_EQUAL(nodes.numNodes, 1);
+}
+
+STUDENT_TEST("buildHuffmanTreeLinear: optimal, round trips, same errors as buildHuffmanTree") {
+    EncodingTreeNode* tree = buildHuffmanTreeLinear("STREETTEST");
+    // T x4, E x3, S x2, R x1: T gets 1 bit, E 2 bits, S and R 3 bits
+    EXPECT_EQUAL(encodedBits(tree, "STREETTEST"), 19);
+    Queue<Bit> bits = encodeText(tree, "STREETTEST");
+    EXPECT_EQUAL(decodeText(tree, bits), "STREETTEST");
+    deallocateTree(tree);
+
+    for (string file : { "res/constitution.txt", "res/dream.txt" }) {
+        string text = readEntireFile(file);
+        EncodingTreeNode* linear = buildHuffmanTreeLinear(text);
+        EncodingTreeNode* original = buildHuffmanTree(text);
+        EXPECT(encodedBits(linear, text) <= encodedBits(original, text));
+        Queue<Bit> message = encodeText(linear, text);
+        EXPECT_EQUAL(decodeText(linear, message), text);
+        deallocateTree(linear);
+        deallocateTree(original);
+    }
+
+    EXPECT_ERROR(buildHuffmanTreeLinear(""));
+    EXPECT_ERROR(buildHuffmanTreeLinear("aaaa"));
+}
+
+STUDENT_TEST("buildHuffmanTree vs buildHuffmanTreeLinear: time trial") {
+    string text;
+    for (int b = 0; b < 256; b++) {
+        text += string(randomInteger(1, 200), (char) b);
+    }
+    for (int copies = 100; copies <= 400; copies *= 2) {
+        string input;
+        for (int i = 0; i < copies; i++) {
+            input += text;
+        }
+        EncodingTreeNode* original = nullptr;
+        EncodingTreeNode* linear = nullptr;
+        TIME_OPERATION(input.size(), original = buildHuffmanTree(input));
+        TIME_OPERATION(input.size(), linear = buildHuffmanTreeLinear(input));
+        deallocateTree(original);
+        deallocateTree(linear);
+    }
+}
@@ -0,0 +1,47 @@
+/* File: huffmanbuild.h
+ * Assignment brief: linear-time Huffman tree construction. Bytes are counted into a flat
+ * 256-entry histogram, the leaves are sorted by weight once, and the tree is built with the
+ * two-queue merge: leaves come off one queue in sorted order, and merged nodes go onto a
+ * second queue, which stays sorted by itself because each merge is at least as heavy as
+ * the one before. Every node carries its weight, so nothing is ever recomputed.
+ */
+#pragma once
+#include "treenode.h"
+#include <cstdint>
+#include <string>
+
+/**
+ * A Huffman tree over byte values in flat arrays. Leaves are nodes 0 .. numLeaves-1, in
+ * increasing order of weight. Every merge adds the next node, so children always have
+ * lower numbers than their parent and the root is node numNodes-1.
+ */
+struct HuffmanNodes {
+    int numLeaves;
+    int numNodes;
+    int64_t weight[511];
+    int zero[511];          // -1 for a leaf
+    int one[511];           // -1 for a leaf
+    uint8_t symbol[511];    // byte value of a leaf
+};
+
+/**
+ * Fills counts[b] with the number of times byte value b occurs in text, using the
+ * histogram kernel in histogram.h.
+ */
+void countBytes(const std::string& text, int64_t counts[256]);
+
+/**
+ * Builds the Huffman tree for the byte values with nonzero counts into nodes. Ties are
+ * broken toward leaves and then toward lower byte values, so the result is deterministic.
+ * With one used value the tree is a single leaf, and with none it is empty. This
+ * operation runs in time O(n log n) for the one sort of the n used values, then O(n).
+ */
+void buildHuffmanNodes(const int64_t counts[256], HuffmanNodes& nodes);
+
+/**
+ * Same contract as buildHuffmanTree in huffman.cpp (same zero/one order for merges), built
+ * with buildHuffmanNodes and then turned into EncodingTreeNodes bottom up.
+ *
+ * Reports an error if the input text does not contain at least two distinct characters.
+ */
+EncodingTreeNode* buildHuffmanTreeLinear(const std::string& text);
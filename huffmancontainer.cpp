@@ -0,0 +1,440 @@
+/* File: huffmancontainer.cpp
+ * Assignment brief: compressed container format with checksums and random access. The
+ * header file, "huffmancontainer.h" is in this repository, along with the layout.
+ */
+#include "huffmancontainer.h"
+#include "byteio.h"
+#include "canonical.h"
+#include "crc32c.h"
+#include "error.h"
+#include "filelib.h"
+#include "strlib.h"
+#include <algorithm>
+#include <sstream>
+#include "testing/SimpleTest.h"
+using namespace std;
+
+const string kContainerMagic = "HFC";
+const string kContainerTrailerMagic = "HFCX";
+const int kContainerHeaderBytes = 8;
+const int kBlockHeaderBytes = 13;
+const int kTrailerBytes = 12;
+
+ContainerWriter::ContainerWriter(ostream& out, int blockSize, int mode) : _out(out) {
+    if (blockSize < 1 || blockSize > kMaxBlockSize) {
+        error("ContainerWriter: blockSize must be between 1 and kMaxBlockSize");
+    }
+    if (mode != kContainerModeCanonical && mode != kContainerModeInterleaved) {
+        error("ContainerWriter: mode must be kContainerModeCanonical or kContainerModeInterleaved");
+    }
+    _blockSize = blockSize;
+    _mode = mode;
+    _numBlocks = 0;
+    _closed = false;
+    string header = kContainerMagic;
+    header += (char) kContainerVersion;
+    appendU32(header, blockSize);
+    _out.write(header.data(), header.size());
+    _offset = header.size();
+}
+
+ContainerWriter::~ContainerWriter() {
+    if (!_closed) {
+        close();
+    }
+}
+
+void ContainerWriter::write(const char* data, size_t size) {
+    if (_closed) {
+        error("ContainerWriter: write after close");
+    }
+    while (size > 0) {
+        size_t take = min(size, _blockSize - _block.size());
+        _block.append(data, take);
+        data += take;
+        size -= take;
+        if (_block.size() == (size_t) _blockSize) {
+            flushBlock();
+        }
+    }
+}
+
+void ContainerWriter::write(const string& data) {
+    write(data.data(), data.size());
+}
+
+/*
+ * Codes the current block, and falls back to storing it when the coded form is no
+ * smaller (random or already-compressed data), so a block never grows by more than its
+ * 13-byte header.
+ */
+void ContainerWriter::flushBlock() {
+    string payload;
+    if (_mode == kContainerModeInterleaved) {
+        payload = compressInterleaved(_block);
+    }
+    else {
+        payload = serializeCanonical(compressCanonical(_block));
+    }
+    int mode = _mode;
+    if (payload.size() >= _block.size()) {
+        payload = _block;
+        mode = kContainerModeStored;
+    }
+    string header;
+    header += (char) mode;
+    appendU32(header, _block.size());
+    appendU32(header, payload.size());
+    appendU32(header, crc32c(_block.data(), _block.size()));
+    _out.write(header.data(), header.size());
+    _out.write(payload.data(), payload.size());
+
+    appendU64(_index, _offset);
+    appendU32(_index, _block.size());
+    _offset += header.size() + payload.size();
+    _numBlocks++;
+    _block.clear();
+}
+
+void ContainerWriter::close() {
+    if (_closed) {
+        return;
+    }
+    if (!_block.empty()) {
+        flushBlock();
+    }
+    string index;
+    appendU32(index, _numBlocks);
+    index += _index;
+    appendU32(index, crc32c(index.data(), index.size()));
+    appendU64(index, _offset);
+    index += kContainerTrailerMagic;
+    _out.write(index.data(), index.size());
+    _out.flush();
+    _closed = true;
+}
+
+/* HELPER FUNCTION: seeks in to offset and reads exactly n bytes from there into buffer,
+ * or reports an error.
+ */
+static void readAt(istream& in, streampos offset, string& buffer, size_t n) {
+    in.clear();
+    in.seekg(offset);
+    buffer.resize(n);
+    if (n > 0 && !in.read(&buffer[0], n)) {
+        error("ContainerReader: container is truncated");
+    }
+}
+
+/*
+ * Every index entry is checked here, so readBlock can trust the offsets: the first block
+ * starts right after the header, each block ends where the next begins, the last one
+ * ends at the index, and no block is bigger than its rawLength allows in any mode.
+ */
+ContainerReader::ContainerReader(istream& in) : _in(in) {
+    _start = in.tellg();
+    if (_start == streampos(-1)) {
+        error("ContainerReader: input is not seekable");
+    }
+    string buffer;
+    readAt(_in, _start, buffer, kContainerHeaderBytes);
+    if (buffer.substr(0, 3) != kContainerMagic) {
+        error("ContainerReader: not a compressed container");
+    }
+    int version = (unsigned char) buffer[3];
+    if (version < 1 || version > kContainerVersion) {
+        error("ContainerReader: unsupported container version " + integerToString(version));
+    }
+    _blockSize = readU32(buffer.data(), 4);
+    if (_blockSize < 1 || _blockSize > (uint32_t) kMaxBlockSize) {
+        error("ContainerReader: bad block size");
+    }
+
+    _in.seekg(0, ios::end);
+    uint64_t length = _in.tellg() - _start;
+    if (length < kContainerHeaderBytes + 8 + kTrailerBytes) {
+        error("ContainerReader: container is truncated");
+    }
+    readAt(_in, _start + streamoff(length - kTrailerBytes), buffer, kTrailerBytes);
+    uint64_t indexOffset = readU64(buffer.data(), 0);
+    if (buffer.substr(8) != kContainerTrailerMagic || indexOffset < kContainerHeaderBytes ||
+            indexOffset > length - kTrailerBytes - 8) {
+        error("ContainerReader: bad trailer");
+    }
+    readAt(_in, _start + streamoff(indexOffset), buffer, length - kTrailerBytes - indexOffset);
+    uint32_t numBlocks = readU32(buffer.data(), 0);
+    if (buffer.size() != 4 + 12 * (uint64_t) numBlocks + 4) {
+        error("ContainerReader: bad index size");
+    }
+    if (crc32c(buffer.data(), buffer.size() - 4) != readU32(buffer.data(), buffer.size() - 4)) {
+        error("ContainerReader: index checksum mismatch");
+    }
+
+    _offsets.resize(numBlocks + 1);
+    _starts.resize(numBlocks + 1);
+    _starts[0] = 0;
+    for (uint32_t b = 0; b < numBlocks; b++) {
+        _offsets[b] = readU64(buffer.data(), 4 + 12 * b);
+        uint32_t rawLength = readU32(buffer.data(), 4 + 12 * b + 8);
+        if (rawLength < 1 || rawLength > _blockSize) {
+            error("ContainerReader: bad block length in index");
+        }
+        _starts[b + 1] = _starts[b] + rawLength;
+    }
+    _offsets[numBlocks] = indexOffset;
+    if (numBlocks > 0 && _offsets[0] != kContainerHeaderBytes) {
+        error("ContainerReader: bad block offset in index");
+    }
+    for (uint32_t b = 0; b < numBlocks; b++) {
+        if (_offsets[b + 1] < _offsets[b] + kBlockHeaderBytes ||
+                _offsets[b + 1] - _offsets[b] - kBlockHeaderBytes > maxInterleavedSize(blockLength(b))) {
+            error("ContainerReader: bad block offset in index");
+        }
+    }
+}
+
+int ContainerReader::numBlocks() const {
+    return _offsets.size() - 1;
+}
+
+int64_t ContainerReader::size() const {
+    return _starts.back();
+}
+
+int64_t ContainerReader::blockStart(int block) const {
+    return _starts[block];
+}
+
+int ContainerReader::blockLength(int block) const {
+    return _starts[block + 1] - _starts[block];
+}
+
+int ContainerReader::blockAt(int64_t position) const {
+    if (position < 0 || position >= size()) {
+        error("ContainerReader: position out of range");
+    }
+    return upper_bound(_starts.begin(), _starts.end(), position) - _starts.begin() - 1;
+}
+
+/*
+ * The block's own header has to agree with the index before its payload is decoded,
+ * and the decoded bytes have to match the block's checksum before they are returned.
+ */
+string ContainerReader::readBlock(int block) {
+    if (block < 0 || block >= numBlocks()) {
+        error("ContainerReader: block out of range");
+    }
+    string bytes;
+    readAt(_in, _start + streamoff(_offsets[block]), bytes, _offsets[block + 1] - _offsets[block]);
+    int mode = (unsigned char) bytes[0];
+    uint32_t rawLength = readU32(bytes.data(), 1);
+    uint32_t payloadLength = readU32(bytes.data(), 5);
+    uint32_t crc = readU32(bytes.data(), 9);
+    if (rawLength != (uint32_t) blockLength(block) || payloadLength != bytes.size() - kBlockHeaderBytes) {
+        error("ContainerReader: block header does not match index");
+    }
+
+    string raw;
+    if (mode == kContainerModeStored) {
+        raw = bytes.substr(kBlockHeaderBytes);
+    }
+    else if (mode == kContainerModeCanonical) {
+        raw = decompressCanonical(deserializeCanonical(bytes.substr(kBlockHeaderBytes)));
+    }
+    else if (mode == kContainerModeInterleaved) {
+        raw = decompressInterleaved(bytes.substr(kBlockHeaderBytes));
+    }
+    else {
+        error("ContainerReader: unknown block mode " + integerToString(mode));
+    }
+    if (raw.size() != rawLength || crc32c(raw.data(), raw.size()) != crc) {
+        error("ContainerReader: block " + integerToString(block) + " checksum mismatch");
+    }
+    return raw;
+}
+
+string ContainerReader::read(int64_t position, int64_t length) {
+    if (position < 0 || length < 0 || position > size() - length) {
+        error("ContainerReader: range out of range");
+    }
+    string result;
+    if (length == 0) {
+        return result;
+    }
+    int first = blockAt(position);
+    int last = blockAt(position + length - 1);
+    for (int b = first; b <= last; b++) {
+        string raw = readBlock(b);
+        int64_t from = max(position, blockStart(b)) - blockStart(b);
+        int64_t to = min(position + length, blockStart(b + 1)) - blockStart(b);
+        result.append(raw, from, to - from);
+    }
+    return result;
+}
+
+void ContainerReader::readAll(ostream& out) {
+    for (int b = 0; b < numBlocks(); b++) {
+        string raw = readBlock(b);
+        out.write(raw.data(), raw.size());
+    }
+    out.flush();
+}
+
+void compressContainer(istream& in, ostream& out, int blockSize, int mode) {
+    ContainerWriter writer(out, blockSize, mode);
+    string buffer(blockSize, '\0');
+    while (in.read(&buffer[0], blockSize) || in.gcount() > 0) {
+        writer.write(buffer.data(), in.gcount());
+    }
+    writer.close();
+}
+
+void decompressContainer(istream& in, ostream& out) {
+    ContainerReader reader(in);
+    reader.readAll(out);
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * */
+
+/* Helper function: compressContainer into a string. */
+static string toContainer(const string& text, int blockSize, int mode = kContainerModeCanonical) {
+    stringstream in(text);
+    stringstream out;
+    compressContainer(in, out, blockSize, mode);
+    return out.str();
+}
+
+STUDENT_TEST("compressContainer -> decompressContainer round trip, coded and stored blocks") {
+    string text = readEntireFile("res/constitution.txt");
+    string random;
+    for (int i = 0; i < 5000; i++) {
+        random += (char) randomInteger(0, 255);
+    }
+    for (int blockSize : { 1, 100, 4096, kDefaultBlockSize }) {
+        for (string input : { text, random, string(""), string("z"), text + random + text }) {
+            if (blockSize == 1) {
+                input = input.substr(0, 500);
+            }
+            stringstream container(toContainer(input, blockSize));
+            stringstream out;
+            decompressContainer(container, out);
+            EXPECT_EQUAL(out.str(), input);
+        }
+    }
+
+    string container = toContainer(random, 4096);
+    EXPECT_EQUAL((int) container[8], kContainerModeStored);
+    EXPECT(container.size() < random.size() + 100);
+    container = toContainer(text, 4096);
+    EXPECT_EQUAL((int) container[8], kContainerModeCanonical);
+    EXPECT(container.size() < text.size() * 2 / 3);
+
+    stringstream out;
+    EXPECT_ERROR(ContainerWriter writer(out, 0));
+    ContainerWriter writer(out, 10);
+    writer.close();
+    EXPECT_ERROR(writer.write("late"));
+}
+
+STUDENT_TEST("ContainerReader: random access to blocks and byte ranges") {
+    string text = readEntireFile("res/dream.txt") + readEntireFile("res/constitution.txt");
+    // The container doesn't have to start at the beginning of the stream
+    stringstream stream("some leading bytes" + toContainer(text, 1000));
+    stream.seekg(18);
+    ContainerReader reader(stream);
+    EXPECT_EQUAL(reader.size(), (int64_t) text.size());
+    EXPECT_EQUAL(reader.numBlocks(), (int) (text.size() + 999) / 1000);
+    for (int b = reader.numBlocks() - 1; b >= 0; b--) {
+        EXPECT_EQUAL(reader.blockStart(b), b * 1000);
+        EXPECT_EQUAL(reader.readBlock(b), text.substr(b * 1000, 1000));
+    }
+    EXPECT_EQUAL(reader.blockAt(0), 0);
+    EXPECT_EQUAL(reader.blockAt(999), 0);
+    EXPECT_EQUAL(reader.blockAt(1000), 1);
+    EXPECT_EQUAL(reader.blockAt(text.size() - 1), reader.numBlocks() - 1);
+    EXPECT_ERROR(reader.blockAt(text.size()));
+    EXPECT_ERROR(reader.readBlock(reader.numBlocks()));
+
+    for (int i = 0; i < 200; i++) {
+        int64_t position = randomInteger(0, text.size());
+        int64_t length = randomInteger(0, min((int64_t) 5000, (int64_t) text.size() - position));
+        EXPECT_EQUAL(reader.read(position, length), text.substr(position, length));
+    }
+    EXPECT_EQUAL(reader.read(0, text.size()), text);
+    EXPECT_ERROR(reader.read(text.size() - 5, 6));
+    EXPECT_ERROR(reader.read(-1, 2));
+}
+
+STUDENT_TEST("ContainerReader rejects bad headers and indexes, and catches corrupt blocks") {
+    string text = readEntireFile("res/constitution.txt");
+    string container = toContainer(text, 4096);
+
+    auto opens = [](const string& bytes) {
+        stringstream stream(bytes);
+        ContainerReader reader(stream);
+        return reader.numBlocks();
+    };
+    EXPECT_EQUAL(opens(container), (int) (text.size() + 4095) / 4096);
+    EXPECT_ERROR(opens("HFZ" + container.substr(3)));
+    string newer = container;
+    newer[3] = kContainerVersion + 1;
+    EXPECT_ERROR(opens(newer));
+    EXPECT_ERROR(opens(container.substr(0, container.size() - 1)));
+    EXPECT_ERROR(opens(container.substr(0, 20)));
+    string badIndex = container;
+    badIndex[readU64(container.data(), container.size() - 12) + 6] ^= 1;
+    EXPECT_ERROR(opens(badIndex));
+
+    // A flipped bit in one block's payload is caught by that block's checksum (or its
+    // decoder), and every other block still reads back
+    string badBlock = container;
+    badBlock[kContainerHeaderBytes + kBlockHeaderBytes + 300] ^= 0x10;
+    stringstream stream(badBlock);
+    ContainerReader reader(stream);
+    EXPECT_ERROR(reader.readBlock(0));
+    for (int b = 1; b < reader.numBlocks(); b++) {
+        EXPECT_EQUAL(reader.readBlock(b), text.substr(b * 4096, 4096));
+    }
+}
+
+STUDENT_TEST("ContainerReader: one block by index vs decompressing the whole container") {
+    string base = readEntireFile("res/constitution.txt");
+    string text;
+    for (int i = 0; i < 256; i++) {
+        text += base;
+    }
+    stringstream stream(toContainer(text, 1 << 16));
+    ContainerReader reader(stream);
+    int middle = reader.numBlocks() / 2;
+    string block;
+    stringstream out;
+
+    TIME_OPERATION(1 << 16, block = reader.readBlock(middle));
+    TIME_OPERATION(text.size(), reader.readAll(out));
+    EXPECT_EQUAL(block, text.substr(reader.blockStart(middle), 1 << 16));
+    EXPECT(out.str() == text);
+}
+
+STUDENT_TEST("Interleaved blocks: round trip and random access") {
+    string text = readEntireFile("res/constitution.txt") + readEntireFile("res/dream.txt");
+    for (int blockSize : { 1, 3, 1000, kDefaultBlockSize }) {
+        string input = (blockSize < 10) ? text.substr(0, 200) : text;
+        stringstream container(toContainer(input, blockSize, kContainerModeInterleaved));
+        stringstream out;
+        decompressContainer(container, out);
+        EXPECT_EQUAL(out.str(), input);
+    }
+    string container = toContainer(text, 4096, kContainerModeInterleaved);
+    EXPECT_EQUAL((int) container[8], kContainerModeInterleaved);
+    stringstream stream(container);
+    ContainerReader reader(stream);
+    for (int i = 0; i < 50; i++) {
+        int64_t position = randomInteger(0, text.size() - 1);
+        int64_t length = randomInteger(0, text.size() - position);
+        EXPECT_EQUAL(reader.read(position, length), text.substr(position, length));
+    }
+
+    stringstream out;
+    EXPECT_ERROR(ContainerWriter(out, 1000, kContainerModeStored));
+}
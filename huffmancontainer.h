@@ -0,0 +1,169 @@
+/* File: huffmancontainer.h
+ * Assignment brief: self-describing on-disk container for Huffman-compressed data, with
+ * checksums and random access. EncodedData only exists in memory; this is a file format
+ * that says what it is, checks what it holds, and can hand back any block of the
+ * original data without decoding the blocks before it.
+ *
+ * Layout (integers are little-endian; offsets are from the start of the container):
+ *
+ *     container := "HFC" version:u8 blockSize:u32 block* index trailer
+ *     block     := mode:u8 rawLength:u32 payloadLength:u32 crc:u32 payload{payloadLength}
+ *     index     := numBlocks:u32 (offset:u64 rawLength:u32){numBlocks} indexCrc:u32
+ *     trailer   := indexOffset:u64 "HFCX"
+ *
+ * crc is the CRC-32C (see crc32c.h) of the block's original bytes, and indexCrc that of
+ * the index bytes before it. mode says how the payload is coded (kContainerModeStored
+ * and so on below), so new modes can be added without breaking old readers of old
+ * files. A reader finds the index through the fixed-size trailer at the end.
+ */
+#pragma once
+#include "testing/MemoryUtils.h"
+#include "huffmanstream.h"
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Container format version written by ContainerWriter. Readers accept this version
+ * and older ones.
+ */
+const int kContainerVersion = 1;
+
+/**
+ * Block payload codings. A block is stored when coding would not make it smaller.
+ */
+const int kContainerModeStored = 0;        // payload is the original bytes
+const int kContainerModeCanonical = 1;     // payload is serializeCanonical(compressCanonical(bytes))
+const int kContainerModeInterleaved = 2;   // payload is compressInterleaved(bytes)
+
+/**
+ * Writes a container to an output stream. Input is collected into blocks of blockSize
+ * bytes, and each full block is coded and written as soon as it fills up. Blocks are
+ * coded with mode (kContainerModeCanonical or kContainerModeInterleaved), or stored.
+ */
+class ContainerWriter {
+public:
+    /**
+     * Creates a writer and writes the container header to out.
+     *
+     * Reports an error if blockSize is not between 1 and kMaxBlockSize, or mode is not a
+     * coding mode.
+     */
+    ContainerWriter(std::ostream& out, int blockSize = kDefaultBlockSize,
+                    int mode = kContainerModeCanonical);
+
+    /**
+     * Calls close() if it hasn't been called yet.
+     */
+    ~ContainerWriter();
+
+    /**
+     * Appends data[0 .. size) to the original data.
+     */
+    void write(const char* data, size_t size);
+    void write(const std::string& data);
+
+    /**
+     * Writes any partially filled block, then the index and trailer. Nothing may be
+     * written after this.
+     */
+    void close();
+
+private:
+    std::ostream& _out;
+    std::string _block;     // original bytes of the current block
+    std::string _index;     // index entries of the blocks written so far
+    uint32_t _numBlocks;
+    uint64_t _offset;       // bytes written to out so far
+    int _blockSize;
+    int _mode;
+    bool _closed;
+
+    void flushBlock();
+
+    DISALLOW_COPYING_OF(ContainerWriter);
+};
+
+/**
+ * Random-access reader for a container. The constructor reads only the header, trailer
+ * and index; after that each block is read and decoded only when it is asked for.
+ * The stream must be seekable and must outlive the reader.
+ */
+class ContainerReader {
+public:
+    /**
+     * Opens the container that starts at the current position of in, and checks its
+     * header and index.
+     *
+     * Reports an error if in is not seekable, is not a container, has a newer version
+     * than kContainerVersion, or has an index that is corrupt or does not fit the file.
+     */
+    ContainerReader(std::istream& in);
+
+    /**
+     * Returns the number of blocks.
+     */
+    int numBlocks() const;
+
+    /**
+     * Returns the number of bytes of original data.
+     */
+    int64_t size() const;
+
+    /**
+     * Returns where block starts in the original data, and how many bytes it holds.
+     */
+    int64_t blockStart(int block) const;
+    int blockLength(int block) const;
+
+    /**
+     * Returns the block that holds byte position of the original data. This operation
+     * runs in time O(log numBlocks).
+     *
+     * Reports an error if position is not between 0 and size() - 1.
+     */
+    int blockAt(int64_t position) const;
+
+    /**
+     * Reads, decodes and checks block, and returns its original bytes.
+     *
+     * Reports an error if block is out of range, or the block is corrupt or fails its
+     * checksum.
+     */
+    std::string readBlock(int block);
+
+    /**
+     * Returns bytes [position, position + length) of the original data, decoding only the
+     * blocks they are in.
+     *
+     * Reports an error if the range is not inside the original data.
+     */
+    std::string read(int64_t position, int64_t length);
+
+    /**
+     * Writes all of the original data to out, one block at a time.
+     */
+    void readAll(std::ostream& out);
+
+private:
+    std::istream& _in;
+    std::streampos _start;              // position of the container in _in
+    uint32_t _blockSize;
+    std::vector<uint64_t> _offsets;     // container offset of each block, then of the index
+    std::vector<int64_t> _starts;       // original-data position of each block, then size()
+
+    DISALLOW_COPYING_OF(ContainerReader);
+};
+
+/**
+ * Reads in until it runs out and writes it to out as a container, coding blocks with mode.
+ */
+void compressContainer(std::istream& in, std::ostream& out, int blockSize = kDefaultBlockSize,
+                       int mode = kContainerModeCanonical);
+
+/**
+ * Reads the container in and writes the original data to out.
+ */
+void decompressContainer(std::istream& in, std::ostream& out);
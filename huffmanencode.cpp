@@ -0,0 +1,300 @@
+/* File: huffmanencode.cpp
+ * Assignment brief: table-driven Huffman encoder. The header file, "huffmanencode.h" is in
+ * this repository.
+ */
+#include "huffmanencode.h"
+#include "huffman.h"
+#include "canonical.h"
+#include "huffmanbuild.h"
+#include "error.h"
+#include "filelib.h"
+#include "map.h"
+#include "strlib.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+HuffmanEncodeTable::HuffmanEncodeTable(EncodingTreeNode* tree) {
+    if (tree == nullptr || tree->isLeaf()) {
+        error("HuffmanEncodeTable: tree needs at least two leaves");
+    }
+    for (int b = 0; b < 256; b++) {
+        _codes[b] = 0;
+        _lengths[b] = 0;
+    }
+    string path;
+    collect(tree, path);
+    setMaxLength();
+}
+
+HuffmanEncodeTable::HuffmanEncodeTable(const uint8_t lengths[256]) {
+    canonicalCodes(lengths, _codes);
+    for (int b = 0; b < 256; b++) {
+        _lengths[b] = lengths[b];
+    }
+    setMaxLength();
+}
+
+/* HELPER FUNCTION: sets _maxLength, the most bits one character can add to the output. */
+void HuffmanEncodeTable::setMaxLength() {
+    _maxLength = 0;
+    for (int b = 0; b < 256; b++) {
+        _maxLength = max(_maxLength, _lengths[b]);
+    }
+}
+
+/* HELPER FUNCTION: records the code of every leaf under node, where path is the code of
+ * node as '0'/'1' characters.
+ */
+void HuffmanEncodeTable::collect(EncodingTreeNode* node, string& path) {
+    if (node->isLeaf()) {
+        unsigned char ch = node->ch;
+        _lengths[ch] = path.size();
+        if (path.size() <= 64) {
+            for (char step : path) {
+                _codes[ch] = (_codes[ch] << 1) | (step == '1');
+            }
+        }
+        else {
+            _longCodes.resize(256);
+            BitWriter writer(_longCodes[ch]);
+            for (char step : path) {
+                writer.writeBit(step == '1');
+            }
+        }
+    }
+    else {
+        path += '0';
+        collect(node->zero, path);
+        path.back() = '1';
+        collect(node->one, path);
+        path.pop_back();
+    }
+}
+
+/*
+ * Same accumulator as BitWriter, kept in locals so the loop does no calls, no count
+ * checks and no partial-word bookkeeping per character. When no code is longer than 16
+ * bits, four codes are first joined into one group of at most 64 bits, so the
+ * accumulator is only tested for a full word once per four characters. Otherwise, and
+ * for the last few characters, they go one at a time, where a length of 0 (character
+ * not in the code) or over 64 takes the slow path. A character not in the code puts out
+ * back the way it was before reporting the error.
+ */
+void HuffmanEncodeTable::encode(const char* data, size_t size, BitBuffer& out) const {
+    vector<uint64_t>& words = out._words;
+    uint64_t acc = 0;
+    int accBits = out._numBits & 63;
+    if (accBits > 0) {
+        acc = words.back();
+        words.pop_back();
+    }
+    int64_t startWords = words.size();
+    uint64_t startPartial = acc;
+
+    auto put = [&](uint64_t code, int length) {
+        int free = 64 - accBits;
+        if (length < free) {
+            acc |= code << (free - length);
+            accBits += length;
+        }
+        else {
+            int spill = length - free;
+            words.push_back(acc | (code >> spill));
+            acc = (spill > 0) ? code << (64 - spill) : 0;
+            accBits = spill;
+        }
+    };
+    auto putOne = [&](unsigned char ch) {
+        int length = _lengths[ch];
+        if ((unsigned) (length - 1) < 64) {
+            put(_codes[ch], length);
+        }
+        else if (length == 0) {
+            words.resize(startWords);
+            if ((out._numBits & 63) > 0) {
+                words.push_back(startPartial);
+            }
+            error("HuffmanEncodeTable: character not in the code");
+        }
+        else {
+            const BitBuffer& code = _longCodes[ch];
+            int64_t fullWords = code._numBits >> 6;
+            for (int64_t w = 0; w < fullWords; w++) {
+                put(code._words[w], 64);
+            }
+            int rest = code._numBits & 63;
+            if (rest > 0) {
+                put(code._words[fullWords] >> (64 - rest), rest);
+            }
+        }
+    };
+
+    const unsigned char* bytes = (const unsigned char*) data;
+    size_t i = 0;
+    if (_maxLength <= 16) {
+        for (; i + 4 <= size; i += 4) {
+            unsigned char a = bytes[i], b = bytes[i + 1], c = bytes[i + 2], d = bytes[i + 3];
+            int la = _lengths[a], lb = _lengths[b], lc = _lengths[c], ld = _lengths[d];
+            if (((la - 1) | (lb - 1) | (lc - 1) | (ld - 1)) < 0) {
+                break;  // one of them is not in the code; putOne reports it below
+            }
+            uint64_t group = (_codes[a] << lb) | _codes[b];
+            group = (group << lc) | _codes[c];
+            group = (group << ld) | _codes[d];
+            put(group, la + lb + lc + ld);
+        }
+    }
+    for (; i < size; i++) {
+        putOne(bytes[i]);
+    }
+
+    out._numBits = (out._numBits & ~63LL) + (words.size() - startWords) * 64 + accBits;
+    if (accBits > 0) {
+        words.push_back(acc);
+    }
+}
+
+void HuffmanEncodeTable::encode(const string& text, BitBuffer& out) const {
+    encode(text.data(), text.size(), out);
+}
+
+int HuffmanEncodeTable::length(unsigned char ch) const {
+    return _lengths[ch];
+}
+
+Queue<Bit> encodeTextTable(EncodingTreeNode* tree, const string& text) {
+    HuffmanEncodeTable table(tree);
+    BitBuffer bits;
+    table.encode(text, bits);
+    return toBitQueue(bits);
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * */
+
+STUDENT_TEST("encodeTextTable matches encodeText on the example tree and real text") {
+    EncodingTreeNode* tree = createExampleTree();
+    Queue<Bit> expected = { 1, 0, 1, 0, 1, 0, 0, 1, 1, 1, 1, 0, 1, 0, 1 }; // STREETS
+    EXPECT_EQUAL(encodeTextTable(tree, "STREETS"), expected);
+    EXPECT_EQUAL(encodeTextTable(tree, "").size(), 0);
+    EXPECT_ERROR(encodeTextTable(tree, "STREETX"));
+    EXPECT_ERROR(encodeTextTable(tree, "XSTREETS"));
+    deallocateTree(tree);
+
+    for (string file : { "res/constitution.txt", "res/dream.txt" }) {
+        string text = readEntireFile(file);
+        EncodingTreeNode* fileTree = buildHuffmanTree(text);
+        EXPECT_EQUAL(encodeTextTable(fileTree, text), encodeText(fileTree, text));
+        deallocateTree(fileTree);
+    }
+
+    EncodingTreeNode* leaf = new EncodingTreeNode('A');
+    EXPECT_ERROR(HuffmanEncodeTable table(leaf));
+    deallocateTree(leaf);
+}
+
+STUDENT_TEST("HuffmanEncodeTable: codes longer than 64 bits, and appending to a partial word") {
+    // A chain: byte i has a code of 81 - i bits, so bytes 0 .. 16 are longer than 64
+    string text;
+    for (int i = 0; i <= 80; i++) {
+        text += string(3, (char) i);
+    }
+    EncodingTreeNode* tree = new EncodingTreeNode((char) 0);
+    for (int i = 1; i <= 80; i++) {
+        tree = new EncodingTreeNode(new EncodingTreeNode((char) i), tree);
+    }
+    HuffmanEncodeTable table(tree);
+    EXPECT_EQUAL(table.length(1), 80);
+    EXPECT_EQUAL(table.length(80), 1);
+    EXPECT_EQUAL(encodeTextTable(tree, text), encodeText(tree, text));
+
+    BitBuffer bits;
+    BitWriter writer(bits);
+    writer.write(0b101, 3);
+    writer.flush();
+    table.encode(text, bits);
+    BitBuffer expected;
+    BitWriter expectedWriter(expected);
+    expectedWriter.write(0b101, 3);
+    expectedWriter.write(toBitBuffer(encodeText(tree, text)));
+    expectedWriter.flush();
+    EXPECT(bits == expected);
+    deallocateTree(tree);
+}
+
+STUDENT_TEST("HuffmanEncodeTable: a character not in the code leaves out unchanged") {
+    EncodingTreeNode* tree = createExampleTree();
+    HuffmanEncodeTable table(tree);
+    string longText;
+    for (int i = 0; i < 40; i++) {
+        longText += "STREETS";
+    }
+    for (int prefix : { 0, 3, 64, 67 }) {
+        BitBuffer bits;
+        BitWriter writer(bits);
+        for (int i = 0; i < prefix; i++) {
+            writer.writeBit(i % 3 == 0);
+        }
+        writer.flush();
+        BitBuffer before = bits;
+        EXPECT_ERROR(table.encode("STREETX", bits));
+        EXPECT(bits == before);
+        EXPECT_ERROR(table.encode(longText + "X", bits));
+        EXPECT(bits == before);
+        table.encode("STREETS", bits);
+        EXPECT_EQUAL(bits.size(), prefix + 15);
+    }
+    deallocateTree(tree);
+}
+
+STUDENT_TEST("HuffmanEncodeTable from canonical code lengths matches compressCanonical") {
+    for (string file : { "res/constitution.txt", "res/dream.txt" }) {
+        string text = readEntireFile(file);
+        CanonicalEncodedData data = compressCanonical(text);
+        uint8_t lengths[256];
+        size_t pos = 0;
+        unpackCodeLengths(data.codeLengths, pos, lengths);
+        HuffmanEncodeTable table(lengths);
+        BitBuffer bits;
+        table.encode(text, bits);
+        EXPECT(bits == data.messageBits);
+        EXPECT_EQUAL(decompressCanonical(data), text);
+    }
+}
+
+/* Helper function that appends the code of each character of text to out with one
+ * BitWriter::write per character.
+ */
+static void writeCodes(const string& text, const uint64_t codes[256], const uint8_t lengths[256], BitBuffer& out) {
+    BitWriter writer(out);
+    for (char ch : text) {
+        writer.write(codes[(unsigned char) ch], lengths[(unsigned char) ch]);
+    }
+}
+
+STUDENT_TEST("encodeText vs BitWriter vs HuffmanEncodeTable: time trial and throughput") {
+    for (string file : { "res/constitution.txt", "res/dream.txt" }) {
+        string base = readEntireFile(file);
+        string text;
+        while (text.size() < (16 << 20)) {
+            text += base;
+        }
+        int64_t counts[256];
+        countBytes(text, counts);
+        uint8_t lengths[256];
+        codeLengthsFromCounts(counts, lengths);
+        uint64_t codes[256];
+        canonicalCodes(lengths, codes);
+        HuffmanEncodeTable table(lengths);
+        EncodingTreeNode* tree = buildHuffmanTree(base);
+
+        cout << "    " << file << ":" << endl;
+        string slice = text.substr(0, 1 << 20);
+        TIME_OPERATION(slice.size(), encodeText(tree, slice));
+        BitBuffer fromWriter, fromTable;
+        TIME_OPERATION(text.size(), writeCodes(text, codes, lengths, fromWriter));
+        TIME_OPERATION(text.size(), table.encode(text, fromTable));
+        EXPECT(fromTable == fromWriter);
+        deallocateTree(tree);
+    }
+}
@@ -0,0 +1,65 @@
+/* File: huffmanencode.h
+ * Assignment brief: table-driven Huffman encoder. encodeText in huffman.cpp builds a
+ * Map<char, Vector<Bit>> of codes and enqueues one Bit at a time. This encoder keeps a
+ * flat 256-entry table of (code, length) pairs, so each character is one table load, and
+ * collects the codes in a 64-bit accumulator that is stored a whole word at a time.
+ */
+#pragma once
+#include "bitbuffer.h"
+#include "bits.h"
+#include "queue.h"
+#include "treenode.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Encode table for the byte values of a Huffman code. Unlike HuffmanDecodeTable it does not
+ * keep a pointer to the tree, so the tree may be freed once the table is built.
+ */
+class HuffmanEncodeTable {
+public:
+    /**
+     * Builds the table for the leaves of tree. This operation runs in time O(number of
+     * tree nodes + total length of codes longer than 64 bits).
+     *
+     * Reports an error if the tree is a single leaf.
+     */
+    HuffmanEncodeTable(EncodingTreeNode* tree);
+
+    /**
+     * Builds the table for the canonical code with these code lengths (see canonical.h).
+     * Byte values with length 0 are not in the code.
+     *
+     * Reports an error if the lengths are not those of a prefix code.
+     */
+    HuffmanEncodeTable(const uint8_t lengths[256]);
+
+    /**
+     * Appends the codes of data[0 .. size) to out.
+     *
+     * Reports an error if data has a character that is not in the code.
+     */
+    void encode(const char* data, size_t size, BitBuffer& out) const;
+    void encode(const std::string& text, BitBuffer& out) const;
+
+    /**
+     * Returns the code length of byte value ch, or 0 if ch is not in the code.
+     */
+    int length(unsigned char ch) const;
+
+private:
+    uint64_t _codes[256];               // right-aligned; 0 for codes longer than 64 bits
+    int _lengths[256];
+    int _maxLength;
+    std::vector<BitBuffer> _longCodes;  // codes longer than 64 bits, indexed by byte value;
+                                        // empty unless the tree has any
+    void collect(EncodingTreeNode* node, std::string& path);
+    void setMaxLength();
+};
+
+/**
+ * Drop-in replacement for encodeText: encodes text with a HuffmanEncodeTable built from
+ * tree and unpacks the bits into a Queue<Bit>.
+ */
+Queue<Bit> encodeTextTable(EncodingTreeNode* tree, const std::string& text);
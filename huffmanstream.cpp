@@ -0,0 +1,422 @@
+/* File: huffmanstream.cpp
+ * Assignment brief: streaming block-based Huffman compression. The header file,
+ * "huffmanstream.h" is in this repository, along with a description of the layout.
+ */
+#include "huffmanstream.h"
+#include "byteio.h"
+#include "canonical.h"
+#include "error.h"
+#include "filelib.h"
+#include "strlib.h"
+#include "workerpool.h"
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "testing/SimpleTest.h"
+using namespace std;
+
+const string kStreamMagic = "HFS1";
+const string kParallelMagic = "HFP1";
+const string kIndexMagic = "HFPX";
+
+/* HELPER FUNCTION: returns the block as it is written to the stream: rawLength,
+ * payloadLength, payload.
+ */
+static string encodeBlock(const string& block) {
+    string payload = serializeCanonical(compressCanonical(block));
+    string encoded;
+    encoded.reserve(8 + payload.size());
+    appendU32(encoded, block.size());
+    appendU32(encoded, payload.size());
+    encoded += payload;
+    return encoded;
+}
+
+/* HELPER FUNCTION: decodes one block payload and checks it has the length its header says. */
+static string decodePayload(const string& payload, uint32_t rawLength) {
+    string raw = decompressCanonical(deserializeCanonical(payload));
+    if (raw.size() != rawLength) {
+        error("decompressStream: block length does not match");
+    }
+    return raw;
+}
+
+/* HELPER FUNCTION: reads exactly n bytes from in into buffer, or reports an error. */
+static void readExactly(istream& in, string& buffer, size_t n) {
+    buffer.resize(n);
+    if (n > 0 && !in.read(&buffer[0], n)) {
+        error("decompressStream: truncated stream");
+    }
+}
+
+/*
+ * The block buffer is allocated once. Every block but the last is exactly blockSize
+ * bytes; the last one is shrunk to what was actually read.
+ */
+void compressStream(istream& in, ostream& out, int blockSize) {
+    if (blockSize < 1 || blockSize > kMaxBlockSize) {
+        error("compressStream: blockSize must be between 1 and kMaxBlockSize");
+    }
+    string header = kStreamMagic;
+    appendU32(header, blockSize);
+    out.write(header.data(), header.size());
+
+    string block(blockSize, '\0');
+    while (true) {
+        in.read(&block[0], blockSize);
+        streamsize got = in.gcount();
+        if (got == 0) {
+            break;
+        }
+        if (got < blockSize) {
+            block.resize(got);
+        }
+        string encoded = encodeBlock(block);
+        out.write(encoded.data(), encoded.size());
+        if (got < blockSize) {
+            break;
+        }
+    }
+
+    string end;
+    appendU32(end, 0);
+    out.write(end.data(), end.size());
+    out.flush();
+}
+
+/*
+ * Lengths read from the stream are checked against the block size before anything is
+ * allocated, so a corrupt stream can't make this reserve gigabytes. A parallel stream
+ * has the same blocks, so it is read the same way and its index is never looked at.
+ */
+void decompressStream(istream& in, ostream& out) {
+    string buffer;
+    readExactly(in, buffer, 8);
+    string magic = buffer.substr(0, 4);
+    if (magic != kStreamMagic && magic != kParallelMagic) {
+        error("decompressStream: not a compressed stream");
+    }
+    uint32_t blockSize = readU32(buffer.data(), 4);
+    if (blockSize < 1 || blockSize > (uint32_t) kMaxBlockSize) {
+        error("decompressStream: bad block size");
+    }
+
+    string payload;
+    while (true) {
+        readExactly(in, buffer, 4);
+        uint32_t rawLength = readU32(buffer.data(), 0);
+        if (rawLength == 0) {
+            break;
+        }
+        readExactly(in, buffer, 4);
+        uint32_t payloadLength = readU32(buffer.data(), 0);
+        if (rawLength > blockSize || payloadLength > maxSerializedCanonicalSize(rawLength)) {
+            error("decompressStream: bad block header");
+        }
+        readExactly(in, payload, payloadLength);
+        string raw = decodePayload(payload, rawLength);
+        out.write(raw.data(), raw.size());
+    }
+    out.flush();
+}
+
+/*
+ * Reading and writing stay on the calling thread; only the coding of a batch is spread
+ * over the pool. The index grows by 12 bytes per block and is written at the end.
+ */
+void compressStreamParallel(istream& in, ostream& out, int blockSize, int numThreads) {
+    if (blockSize < 1 || blockSize > kMaxBlockSize) {
+        error("compressStreamParallel: blockSize must be between 1 and kMaxBlockSize");
+    }
+    WorkerPool pool(numThreads);
+    string header = kParallelMagic;
+    appendU32(header, blockSize);
+    out.write(header.data(), header.size());
+    uint64_t offset = header.size();
+
+    string index;
+    uint32_t numBlocks = 0;
+    vector<string> blocks(pool.size());
+    vector<string> encoded(pool.size());
+    bool more = true;
+    while (more) {
+        int count = 0;
+        while (more && count < pool.size()) {
+            blocks[count].resize(blockSize);
+            in.read(&blocks[count][0], blockSize);
+            streamsize got = in.gcount();
+            more = (got == blockSize);
+            if (got > 0) {
+                blocks[count].resize(got);
+                count++;
+            }
+        }
+        pool.run(count, [&](int i) { encoded[i] = encodeBlock(blocks[i]); });
+        for (int i = 0; i < count; i++) {
+            appendU64(index, offset);
+            appendU32(index, blocks[i].size());
+            out.write(encoded[i].data(), encoded[i].size());
+            offset += encoded[i].size();
+            numBlocks++;
+        }
+    }
+
+    string trailer;
+    appendU32(trailer, 0);
+    appendU32(trailer, numBlocks);
+    trailer += index;
+    appendU64(trailer, offset + 4);
+    trailer += kIndexMagic;
+    out.write(trailer.data(), trailer.size());
+    out.flush();
+}
+
+/*
+ * Every offset in the index is checked before any block is read: the first block comes
+ * right after the header, each block ends where the next begins, and the last one ends
+ * at the 0 marker before the index. So a batch is one contiguous read, and each block's
+ * own header only has to agree with the index.
+ */
+void decompressStreamParallel(istream& in, ostream& out, int numThreads) {
+    streampos start = in.tellg();
+    if (start == streampos(-1)) {
+        error("decompressStreamParallel: input is not seekable");
+    }
+    string buffer;
+    readExactly(in, buffer, 8);
+    if (buffer.substr(0, 4) != kParallelMagic) {
+        error("decompressStreamParallel: not a parallel compressed stream");
+    }
+    uint32_t blockSize = readU32(buffer.data(), 4);
+    if (blockSize < 1 || blockSize > (uint32_t) kMaxBlockSize) {
+        error("decompressStreamParallel: bad block size");
+    }
+
+    in.seekg(0, ios::end);
+    uint64_t length = in.tellg() - start;
+    if (length < 8 + 4 + 4 + 12) {
+        error("decompressStreamParallel: truncated stream");
+    }
+    in.seekg(start + streamoff(length - 12));
+    readExactly(in, buffer, 12);
+    uint64_t indexOffset = readU64(buffer.data(), 0);
+    if (buffer.substr(8) != kIndexMagic || indexOffset < 12 || indexOffset > length - 16) {
+        error("decompressStreamParallel: bad index trailer");
+    }
+    in.seekg(start + streamoff(indexOffset));
+    readExactly(in, buffer, length - 12 - indexOffset);
+    uint32_t numBlocks = readU32(buffer.data(), 0);
+    if (buffer.size() != 4 + 12 * (uint64_t) numBlocks) {
+        error("decompressStreamParallel: bad index size");
+    }
+
+    vector<uint64_t> offsets(numBlocks + 1);
+    vector<uint32_t> rawLengths(numBlocks);
+    for (uint32_t b = 0; b < numBlocks; b++) {
+        offsets[b] = readU64(buffer.data(), 4 + 12 * b);
+        rawLengths[b] = readU32(buffer.data(), 4 + 12 * b + 8);
+    }
+    offsets[numBlocks] = indexOffset - 4;
+    if (offsets[0] != 8) {
+        error("decompressStreamParallel: bad block offset");
+    }
+    for (uint32_t b = 0; b < numBlocks; b++) {
+        if (rawLengths[b] < 1 || rawLengths[b] > blockSize || offsets[b + 1] < offsets[b] + 8 ||
+                offsets[b + 1] - offsets[b] - 8 > maxSerializedCanonicalSize(rawLengths[b])) {
+            error("decompressStreamParallel: bad block offset");
+        }
+    }
+
+    WorkerPool pool(numThreads);
+    vector<string> decoded(pool.size());
+    string range;
+    in.seekg(start + streamoff(8));
+    for (uint32_t first = 0; first < numBlocks; first += pool.size()) {
+        int count = min((uint32_t) pool.size(), numBlocks - first);
+        readExactly(in, range, offsets[first + count] - offsets[first]);
+        pool.run(count, [&](int i) {
+            size_t pos = offsets[first + i] - offsets[first];
+            uint32_t payloadLength = offsets[first + i + 1] - offsets[first + i] - 8;
+            if (readU32(range.data(), pos) != rawLengths[first + i] ||
+                    readU32(range.data(), pos + 4) != payloadLength) {
+                error("decompressStreamParallel: block header does not match index");
+            }
+            decoded[i] = decodePayload(range.substr(pos + 8, payloadLength), rawLengths[first + i]);
+        });
+        for (int i = 0; i < count; i++) {
+            out.write(decoded[i].data(), decoded[i].size());
+        }
+    }
+    out.flush();
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * */
+
+/* Helper function: compressStream then decompressStream. */
+static string streamRoundTrip(const string& text, int blockSize) {
+    stringstream in(text);
+    stringstream compressed;
+    compressStream(in, compressed, blockSize);
+    stringstream out;
+    decompressStream(compressed, out);
+    return out.str();
+}
+
+STUDENT_TEST("compressStream -> decompressStream round trip for many block sizes") {
+    string text = readEntireFile("res/constitution.txt");
+    for (int blockSize : { 1, 2, 7, 4096, 10000, kDefaultBlockSize }) {
+        string input = (blockSize < 100) ? text.substr(0, 3000) : text;
+        EXPECT_EQUAL(streamRoundTrip(input, blockSize), input);
+    }
+
+    string every;
+    for (int b = 0; b < 256; b++) {
+        every += string(300, (char) b);
+    }
+    EXPECT_EQUAL(streamRoundTrip(every, 1000), every);
+    EXPECT_EQUAL(streamRoundTrip("", 100), "");
+    EXPECT_EQUAL(streamRoundTrip("z", 100), "z");
+    EXPECT_EQUAL(streamRoundTrip(string(100, 'z'), 100), string(100, 'z'));
+
+    stringstream in(text);
+    stringstream out;
+    EXPECT_ERROR(compressStream(in, out, 0));
+    EXPECT_ERROR(compressStream(in, out, kMaxBlockSize + 1));
+}
+
+STUDENT_TEST("decompressStream rejects streams that aren't valid") {
+    stringstream in(readEntireFile("res/dream.txt"));
+    stringstream compressed;
+    compressStream(in, compressed, 512);
+    string bytes = compressed.str();
+
+    stringstream out;
+    stringstream notStream("HFS0 hello");
+    EXPECT_ERROR(decompressStream(notStream, out));
+    stringstream truncated(bytes.substr(0, bytes.size() - 10));
+    EXPECT_ERROR(decompressStream(truncated, out));
+    string badLength = bytes;
+    badLength[8] = (char) 0xFF;
+    badLength[9] = (char) 0xFF;
+    stringstream corrupt(badLength);
+    EXPECT_ERROR(decompressStream(corrupt, out));
+}
+
+STUDENT_TEST("compressStream / decompressStream: time trial, throughput and ratio") {
+    string base = readEntireFile("res/constitution.txt");
+    for (int copies = 64; copies <= 256; copies *= 2) {
+        string text;
+        for (int i = 0; i < copies; i++) {
+            text += base;
+        }
+        stringstream in(text);
+        stringstream compressed;
+        stringstream out;
+        TIME_OPERATION(text.size(), compressStream(in, compressed));
+        TIME_OPERATION(text.size(), decompressStream(compressed, out));
+        EXPECT(out.str() == text);
+        EXPECT(compressed.str().size() * 3 < text.size() * 2);
+    }
+}
+
+STUDENT_TEST("WorkerPool runs every job exactly once and passes errors back") {
+    for (int threads : { 1, 2, 4, 7 }) {
+        WorkerPool pool(threads);
+        EXPECT_EQUAL(pool.size(), threads);
+        for (int numJobs : { 0, 1, 3, 100 }) {
+            vector<atomic<int>> runs(numJobs);
+            pool.run(numJobs, [&](int i) { runs[i]++; });
+            for (int i = 0; i < numJobs; i++) {
+                EXPECT_EQUAL(runs[i].load(), 1);
+            }
+        }
+        EXPECT_ERROR(pool.run(10, [](int i) { if (i == 5) error("job 5 failed"); }));
+        atomic<int> total(0);
+        pool.run(10, [&](int i) { total += i; });
+        EXPECT_EQUAL(total.load(), 45);
+    }
+}
+
+/* Helper function: compressStreamParallel then decompressStreamParallel. */
+static string parallelRoundTrip(const string& text, int blockSize, int numThreads) {
+    stringstream in(text);
+    stringstream compressed;
+    compressStreamParallel(in, compressed, blockSize, numThreads);
+    stringstream out;
+    decompressStreamParallel(compressed, out, numThreads);
+    return out.str();
+}
+
+STUDENT_TEST("compressStreamParallel -> decompressStreamParallel round trip") {
+    string text = readEntireFile("res/constitution.txt");
+    for (int threads : { 1, 2, 3, 8 }) {
+        for (int blockSize : { 7, 4096, 10000, kDefaultBlockSize }) {
+            string input = (blockSize < 100) ? text.substr(0, 3000) : text;
+            EXPECT_EQUAL(parallelRoundTrip(input, blockSize, threads), input);
+        }
+        EXPECT_EQUAL(parallelRoundTrip("", 100, threads), "");
+        EXPECT_EQUAL(parallelRoundTrip("z", 100, threads), "z");
+        EXPECT_EQUAL(parallelRoundTrip(string(300, 'z'), 100, threads), string(300, 'z'));
+    }
+
+    // The blocks are the same as compressStream's, so the sequential decoder reads them too.
+    stringstream in(text);
+    stringstream parallel;
+    compressStreamParallel(in, parallel, 4096, 4);
+    stringstream out;
+    decompressStream(parallel, out);
+    EXPECT_EQUAL(out.str(), text);
+}
+
+STUDENT_TEST("decompressStreamParallel rejects streams and indexes that aren't valid") {
+    stringstream in(readEntireFile("res/dream.txt"));
+    stringstream compressed;
+    compressStreamParallel(in, compressed, 512, 2);
+    string bytes = compressed.str();
+    stringstream out;
+
+    stringstream sequential;
+    stringstream again(readEntireFile("res/dream.txt"));
+    compressStream(again, sequential, 512);
+    EXPECT_ERROR(decompressStreamParallel(sequential, out));
+
+    stringstream truncated(bytes.substr(0, bytes.size() - 1));
+    EXPECT_ERROR(decompressStreamParallel(truncated, out));
+
+    // The index starts after the 0 marker; its first entry is the offset of block 0.
+    uint64_t indexOffset = readU64(bytes.data(), bytes.size() - 12);
+    string badOffset = bytes;
+    badOffset[indexOffset + 4] = 9;
+    stringstream corruptOffset(badOffset);
+    EXPECT_ERROR(decompressStreamParallel(corruptOffset, out));
+
+    string badLength = bytes;
+    badLength[indexOffset + 4 + 8] ^= 1;
+    stringstream corruptLength(badLength);
+    EXPECT_ERROR(decompressStreamParallel(corruptLength, out));
+
+    string badPayload = bytes;
+    badPayload[12] = (char) 0xFF;
+    stringstream corruptPayload(badPayload);
+    EXPECT_ERROR(decompressStreamParallel(corruptPayload, out));
+}
+
+STUDENT_TEST("compressStreamParallel / decompressStreamParallel: time trial by thread count") {
+    string base = readEntireFile("res/constitution.txt");
+    string text;
+    for (int i = 0; i < 256; i++) {
+        text += base;
+    }
+    for (int threads : { 1, 2, 4, 8 }) {
+        cout << "    " << threads << " threads:" << endl;
+        stringstream in(text);
+        stringstream compressed;
+        stringstream out;
+        TIME_OPERATION(text.size(), compressStreamParallel(in, compressed, 1 << 18, threads));
+        TIME_OPERATION(text.size(), decompressStreamParallel(compressed, out, threads));
+        EXPECT(out.str() == text);
+    }
+}
@@ -0,0 +1,72 @@
+/* File: huffmanstream.h
+ * Assignment brief: streaming Huffman compression for inputs larger than memory. The input
+ * is cut into fixed-size blocks and each block is coded on its own with canonical codes
+ * (see canonical.h), so only one block is ever held in memory.
+ *
+ * Layout (integers are little-endian u32):
+ *
+ *     stream := "HFS1" blockSize block* 0
+ *     block  := rawLength payloadLength payload{payloadLength}
+ *
+ * where payload is serializeCanonical(compressCanonical(block bytes)) and rawLength is
+ * never 0.
+ *
+ * The parallel codec writes the same blocks under a different magic number, followed by
+ * an index that says where each block starts, so a reader can hand blocks to threads
+ * without parsing the ones before them (offsets are u64, from the start of the stream):
+ *
+ *     parallel := "HFP1" blockSize block* 0 index indexOffset "HFPX"
+ *     index    := numBlocks (offset rawLength){numBlocks}
+ */
+#pragma once
+#include <istream>
+#include <ostream>
+
+/**
+ * Default block size for compressStream: large enough that the per-block code-length
+ * header is noise, small enough to keep memory use modest.
+ */
+const int kDefaultBlockSize = 1 << 20;
+
+/**
+ * Largest block size compressStream accepts.
+ */
+const int kMaxBlockSize = 1 << 26;
+
+/**
+ * Reads in until it runs out and writes the compressed stream to out, blockSize bytes of
+ * input at a time. Memory use is O(blockSize) however long the input is.
+ *
+ * Reports an error if blockSize is not between 1 and kMaxBlockSize.
+ */
+void compressStream(std::istream& in, std::ostream& out, int blockSize = kDefaultBlockSize);
+
+/**
+ * Reads a stream written by compressStream from in and writes the original bytes to out,
+ * one block at a time.
+ *
+ * Reports an error if in is not a valid compressed stream.
+ */
+void decompressStream(std::istream& in, std::ostream& out);
+
+/**
+ * Same output as compressStream except for the magic number and the trailing block index.
+ * Reads numThreads blocks at a time, compresses them on a WorkerPool (see workerpool.h),
+ * and writes them out in input order. numThreads = 0 means one per hardware thread.
+ * Memory use is O(numThreads * blockSize).
+ *
+ * Reports an error if blockSize is not between 1 and kMaxBlockSize.
+ */
+void compressStreamParallel(std::istream& in, std::ostream& out,
+                            int blockSize = kDefaultBlockSize, int numThreads = 0);
+
+/**
+ * Reads a stream written by compressStreamParallel and writes the original bytes to out.
+ * The index is read first, which needs in to be seekable. Then numThreads blocks at a
+ * time are read as one range, decoded on a WorkerPool, and written out in order.
+ * decompressStream can also read these streams, one block at a time.
+ *
+ * Reports an error if in is not a valid parallel stream or its index does not match
+ * its blocks.
+ */
+void decompressStreamParallel(std::istream& in, std::ostream& out, int numThreads = 0);
@@ -0,0 +1,212 @@
+/* File: huffmantable.cpp
+ * Assignment brief: table-driven Huffman decoder. The header file, "huffmantable.h" is in
+ * this repository.
+ */
+#include "huffmantable.h"
+#include "huffman.h"
+#include "error.h"
+#include "filelib.h"
+#include "strlib.h"
+#include "testing/SimpleTest.h"
+using namespace std;
+
+HuffmanDecodeTable::HuffmanDecodeTable(EncodingTreeNode* tree, int tableBits) {
+    if (tableBits < 1 || tableBits > 16) {
+        error("HuffmanDecodeTable: tableBits must be between 1 and 16");
+    }
+    if (tree == nullptr || tree->isLeaf()) {
+        error("HuffmanDecodeTable: tree needs at least two leaves");
+    }
+    _tableBits = tableBits;
+    _entries = new Entry[1 << tableBits];
+    fill(tree, 0, 0);
+}
+
+HuffmanDecodeTable::~HuffmanDecodeTable() {
+    delete[] _entries;
+}
+
+/* HELPER FUNCTION: walks the top tableBits levels of the tree. A leaf at depth d owns every
+ * entry whose first d bits are its code. A node still internal at depth tableBits gets
+ * the single entry for its path, to be finished bit by bit.
+ */
+void HuffmanDecodeTable::fill(EncodingTreeNode* node, uint32_t code, int depth) {
+    if (node->isLeaf()) {
+        int span = _tableBits - depth;
+        uint32_t start = code << span;
+        for (uint32_t i = 0; i < (1u << span); i++) {
+            _entries[start + i] = { node, depth };
+        }
+    }
+    else if (depth == _tableBits) {
+        _entries[code] = { node, depth };
+    }
+    else {
+        fill(node->zero, code << 1, depth + 1);
+        fill(node->one, (code << 1) | 1, depth + 1);
+    }
+}
+
+/*
+ * The unread bits are kept left-aligned in a 64-bit window that is topped up a byte at a
+ * time whenever it runs low, so the next tableBits bits are window >> (64 - tableBits). Past the end
+ * of the input the window fills with zeros; remaining says how many of its bits are real.
+ */
+string HuffmanDecodeTable::decode(const char* packed, int64_t numBits) const {
+    const unsigned char* bytes = (const unsigned char*) packed;
+    int64_t numBytes = (numBits + 7) / 8;
+    int64_t nextByte = 0;
+    uint64_t window = 0;
+    int windowBits = 0;
+    int64_t remaining = numBits;
+    int shift = 64 - _tableBits;
+
+    auto refill = [&]() {
+        while (windowBits <= 56) {
+            uint64_t byte = nextByte < numBytes ? bytes[nextByte] : 0;
+            nextByte++;
+            window |= byte << (56 - windowBits);
+            windowBits += 8;
+        }
+    };
+
+    string msg;
+    while (remaining > 0) {
+        if (windowBits < _tableBits) {
+            refill();
+        }
+        const Entry& entry = _entries[window >> shift];
+        EncodingTreeNode* node = entry.node;
+        window <<= entry.length;
+        windowBits -= entry.length;
+        remaining -= entry.length;
+        while (!node->isLeaf()) {
+            if (windowBits == 0) {
+                refill();
+            }
+            node = (window >> 63) ? node->one : node->zero;
+            window <<= 1;
+            windowBits--;
+            remaining--;
+        }
+        if (remaining < 0) {
+            error("HuffmanDecodeTable: message bits end in the middle of a code");
+        }
+        msg += node->ch;
+    }
+    return msg;
+}
+
+/*
+ * Same loop over a BitReader, which can peek tableBits bits at any position directly.
+ */
+string HuffmanDecodeTable::decode(BitReader& bits) const {
+    string msg;
+    while (bits.remaining() > 0) {
+        const Entry& entry = _entries[bits.peek(_tableBits)];
+        EncodingTreeNode* node = entry.node;
+        bits.skip(entry.length);
+        while (!node->isLeaf()) {
+            node = bits.peek(1) ? node->one : node->zero;
+            bits.skip(1);
+        }
+        if (bits.remaining() < 0) {
+            error("HuffmanDecodeTable: message bits end in the middle of a code");
+        }
+        msg += node->ch;
+    }
+    return msg;
+}
+
+int HuffmanDecodeTable::tableBits() const {
+    return _tableBits;
+}
+
+/* HELPER FUNCTION: packs bits 8 to a byte, first bit in the high bit. Empties bits. */
+static string packBitQueue(Queue<Bit>& bits) {
+    string packed((bits.size() + 7) / 8, '\0');
+    for (int i = 0; !bits.isEmpty(); i++) {
+        if (bits.dequeue() == 1) {
+            packed[i / 8] |= (char) (0x80 >> (i % 8));
+        }
+    }
+    return packed;
+}
+
+string decodeTextTable(EncodingTreeNode* tree, Queue<Bit>& messageBits) {
+    int64_t numBits = messageBits.size();
+    string packed = packBitQueue(messageBits);
+    HuffmanDecodeTable table(tree);
+    return table.decode(packed.data(), numBits);
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * */
+
+STUDENT_TEST("decodeTextTable matches the provided decodeText examples, for every table size") {
+    EncodingTreeNode* tree = createExampleTree();
+    for (int tableBits = 1; tableBits <= 12; tableBits++) {
+        HuffmanDecodeTable table(tree, tableBits);
+        Queue<Bit> messageBits = { 1, 0, 1, 0, 1, 0, 0, 1, 1, 1, 1, 0, 1, 0, 1 }; // STREETS
+        string packed = packBitQueue(messageBits);
+        EXPECT_EQUAL(table.decode(packed.data(), 15), "STREETS");
+        EXPECT_EQUAL(table.decode(packed.data(), 0), "");
+        EXPECT_ERROR(table.decode(packed.data(), 14));
+    }
+    Queue<Bit> messageBits = { 1, 0, 1, 1, 1, 0 }; // SET
+    EXPECT_EQUAL(decodeTextTable(tree, messageBits), "SET");
+    EXPECT_ERROR(HuffmanDecodeTable(tree, 0));
+    EXPECT_ERROR(HuffmanDecodeTable(tree, 17));
+    deallocateTree(tree);
+
+    EncodingTreeNode* leaf = new EncodingTreeNode('A');
+    EXPECT_ERROR(HuffmanDecodeTable(leaf, 8));
+    deallocateTree(leaf);
+}
+
+STUDENT_TEST("table decoder handles codes longer than the table (skewed frequencies)") {
+    // Fibonacci-like counts give a very deep tree, so many codes go through the fallback
+    string text;
+    int count = 1, previous = 1;
+    for (char ch = 'a'; ch <= 'r'; ch++) {
+        text += string(count, ch);
+        int next = count + previous;
+        previous = count;
+        count = next;
+    }
+    EncodedData data = compress(text);
+    Queue<Bit> treeShape = data.treeShape;
+    Queue<char> treeLeaves = data.treeLeaves;
+    EncodingTreeNode* tree = unflattenTree(treeShape, treeLeaves);
+    for (int tableBits : { 1, 4, 8, 12 }) {
+        Queue<Bit> messageBits = data.messageBits;
+        int64_t numBits = messageBits.size();
+        string packed = packBitQueue(messageBits);
+        HuffmanDecodeTable table(tree, tableBits);
+        EXPECT_EQUAL(table.decode(packed.data(), numBits), text);
+    }
+    deallocateTree(tree);
+}
+
+STUDENT_TEST("decodeText vs HuffmanDecodeTable: time trial and throughput") {
+    string base = readEntireFile("res/constitution.txt");
+    for (int copies = 4; copies <= 16; copies *= 2) {
+        string text;
+        for (int i = 0; i < copies; i++) {
+            text += base;
+        }
+        EncodedData data = compress(text);
+        EncodingTreeNode* tree = unflattenTree(data.treeShape, data.treeLeaves);
+        Queue<Bit> bitsForTree = data.messageBits;
+        int64_t numBits = data.messageBits.size();
+        string packed = packBitQueue(data.messageBits);
+        HuffmanDecodeTable table(tree, 12);
+
+        string fromTree, fromTable;
+        TIME_OPERATION(text.size(), fromTree = decodeText(tree, bitsForTree));
+        TIME_OPERATION(text.size(), fromTable = table.decode(packed.data(), numBits));
+        EXPECT_EQUAL(fromTree, text);
+        EXPECT_EQUAL(fromTable, text);
+        deallocateTree(tree);
+    }
+}
@@ -0,0 +1,72 @@
+/* File: huffmantable.h
+ * Assignment brief: table-driven Huffman decoder. decodeText in huffman.cpp follows one tree
+ * pointer per bit. This decoder looks at the next tableBits bits at once: one table hit
+ * gives the symbol and its code length for every code of at most tableBits bits, and
+ * longer (rare) codes continue down the tree from the node the table points at.
+ */
+#pragma once
+#include "testing/MemoryUtils.h"
+#include "bitbuffer.h"
+#include "bits.h"
+#include "queue.h"
+#include "treenode.h"
+#include <cstdint>
+#include <string>
+
+/**
+ * Decode table built from an encoding tree. The tree must stay alive as long as the
+ * table, since codes longer than tableBits finish decoding by walking it.
+ *
+ * The input is the message bits packed 8 to a byte, first bit in the high bit of the
+ * first byte (the packing used by packEncodedData in dparchive.cpp).
+ */
+class HuffmanDecodeTable {
+public:
+    /**
+     * Builds a table with 2^tableBits entries. This operation runs in time
+     * O(2^tableBits + number of tree nodes).
+     *
+     * Reports an error if tableBits is not between 1 and 16, or the tree is a single leaf.
+     */
+    HuffmanDecodeTable(EncodingTreeNode* tree, int tableBits = 10);
+
+    ~HuffmanDecodeTable();
+
+    /**
+     * Decodes the first numBits bits of packed and returns the message.
+     *
+     * Reports an error if the bits end in the middle of a code.
+     */
+    std::string decode(const char* packed, int64_t numBits) const;
+
+    /**
+     * Decodes every bit left in bits and returns the message.
+     *
+     * Reports an error if the bits end in the middle of a code.
+     */
+    std::string decode(BitReader& bits) const;
+
+    /**
+     * Returns the number of bits the table looks at at once.
+     */
+    int tableBits() const;
+
+private:
+    struct Entry {
+        EncodingTreeNode* node;     // leaf for the symbol, or the subtree to continue from
+        int length;                 // bits consumed by this entry (at most tableBits)
+    };
+
+    Entry* _entries;
+    int _tableBits;
+
+    void fill(EncodingTreeNode* node, uint32_t code, int depth);
+
+    DISALLOW_COPYING_OF(HuffmanDecodeTable);
+};
+
+/**
+ * Drop-in replacement for decodeText: packs messageBits (emptying it) and decodes them
+ * with a HuffmanDecodeTable built from tree.
+ */
+std::string decodeTextTable(EncodingTreeNode* tree, Queue<Bit>& messageBits);
@@ -0,0 +1,306 @@
+/* File: intern.cpp
+ * Assignment brief: string arena for interned DataPoint names, plus the handle versions of
+ * the client functions. The header file, "intern.h" is in this repository.
+ */
+#include "intern.h"
+#include "pqclient.h"
+#include "pqheap.h"
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include "testing/SimpleTest.h"
+using namespace std;
+
+const int INITIAL_ARENA_BYTES = 256;
+const int INITIAL_ARENA_IDS = 16;
+const int INITIAL_ARENA_SLOTS = 32;     // power of two, and kept at least twice the number of ids
+
+/* HELPER FUNCTION: 32-bit FNV-1a hash of data[0 .. length). */
+static unsigned int hashBytes(const char* data, int length) {
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash ^= (unsigned char) data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/* HELPER FUNCTION: doubles the capacity of a dynamic array holding filled elements. */
+template <typename T>
+static void growArray(T*& array, int& allocated, int filled) {
+    T* bigger = new T[allocated * 2];
+    for (int i = 0; i < filled; i++) {
+        bigger[i] = array[i];
+    }
+    delete[] array;
+    array = bigger;
+    allocated *= 2;
+}
+
+StringArena::StringArena() {
+    _bytesAllocated = INITIAL_ARENA_BYTES;
+    _bytes = new char[_bytesAllocated];
+    _numBytes = 0;
+    _idsAllocated = INITIAL_ARENA_IDS;
+    _offsets = new int[_idsAllocated + 1];
+    _offsets[0] = 0;
+    _numIds = 0;
+    _numSlots = INITIAL_ARENA_SLOTS;
+    _slots = new int[_numSlots];
+    fill(_slots, _slots + _numSlots, -1);
+}
+
+StringArena::~StringArena() {
+    delete[] _bytes;
+    delete[] _offsets;
+    delete[] _slots;
+}
+
+/* HELPER FUNCTION: linear probing from the hash. Returns the slot holding the id of
+ * data[0 .. length), or the empty slot where it would go.
+ */
+int StringArena::findSlot(const char* data, int length, unsigned int hash) const {
+    int mask = _numSlots - 1;
+    int slot = hash & mask;
+    while (_slots[slot] != -1) {
+        int id = _slots[slot];
+        int start = _offsets[id];
+        if (_offsets[id + 1] - start == length && memcmp(_bytes + start, data, length) == 0) {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/* HELPER FUNCTION: doubles the hash table and reinserts every id. */
+void StringArena::growSlots() {
+    delete[] _slots;
+    _numSlots *= 2;
+    _slots = new int[_numSlots];
+    fill(_slots, _slots + _numSlots, -1);
+    for (int id = 0; id < _numIds; id++) {
+        int start = _offsets[id];
+        int length = _offsets[id + 1] - start;
+        _slots[findSlot(_bytes + start, length, hashBytes(_bytes + start, length))] = id;
+    }
+}
+
+/*
+ * A hit costs one hash and one memcmp. A miss appends the bytes and the end offset, and
+ * grows the hash table once it would be more than half full.
+ */
+int StringArena::intern(const char* data, int length) {
+    unsigned int hash = hashBytes(data, length);
+    int slot = findSlot(data, length, hash);
+    if (_slots[slot] != -1) {
+        return _slots[slot];
+    }
+
+    while (_numBytes + length > _bytesAllocated) {
+        growArray(_bytes, _bytesAllocated, _numBytes);
+    }
+    memcpy(_bytes + _numBytes, data, length);
+    _numBytes += length;
+    if (_numIds == _idsAllocated) {
+        int offsetsAllocated = _idsAllocated + 1;
+        growArray(_offsets, offsetsAllocated, _numIds + 1);
+        _idsAllocated = offsetsAllocated - 1;
+    }
+    int id = _numIds;
+    _numIds++;
+    _offsets[_numIds] = _numBytes;
+
+    if (2 * _numIds > _numSlots) {
+        growSlots();
+    }
+    else {
+        _slots[slot] = id;
+    }
+    return id;
+}
+
+int StringArena::intern(const string& s) {
+    return intern(s.data(), s.size());
+}
+
+int StringArena::find(const string& s) const {
+    return _slots[findSlot(s.data(), s.size(), hashBytes(s.data(), s.size()))];
+}
+
+string StringArena::lookup(int id) const {
+    if (id < 0 || id >= _numIds) {
+        error("StringArena: id out of range");
+    }
+    return string(_bytes + _offsets[id], _offsets[id + 1] - _offsets[id]);
+}
+
+int StringArena::size() const {
+    return _numIds;
+}
+
+int StringArena::bytesUsed() const {
+    return _numBytes;
+}
+
+bool operator==(const DataPointHandle& lhs, const DataPointHandle& rhs) {
+    return lhs.nameId == rhs.nameId && lhs.priority == rhs.priority;
+}
+
+bool operator!=(const DataPointHandle& lhs, const DataPointHandle& rhs) {
+    return !(lhs == rhs);
+}
+
+ostream& operator<<(ostream& out, const DataPointHandle& handle) {
+    return out << "{ #" << handle.nameId << ", " << handle.priority << " }";
+}
+
+DataPointHandle internDataPoint(const DataPoint& point, StringArena& names) {
+    return { names.intern(point.name), point.priority };
+}
+
+DataPoint resolve(const DataPointHandle& handle, const StringArena& names) {
+    return { names.lookup(handle.nameId), handle.priority };
+}
+
+void pqSort(Vector<DataPointHandle>& v) {
+    HandleHeap pq;
+    for (int i = 0; i < v.size(); i++) {
+        pq.enqueue(v[i]);
+    }
+    for (int i = 0; i < v.size(); i++) {
+        v[i] = pq.dequeue();
+    }
+}
+
+/*
+ * Handles are two ints, so the bounded heap is cheap enough that this skips the selection
+ * strategy topK(Vector<DataPoint>) switches to for large k.
+ */
+Vector<DataPointHandle> topK(const Vector<DataPointHandle>& v, int k) {
+    HandleHeap pq;
+    for (const DataPointHandle& handle : v) {
+        offerTopK(pq, handle, k);
+    }
+    return drainDescending(pq);
+}
+
+/*
+ * The name is only interned when the point makes it into the heap, so names that never
+ * rank don't grow the arena.
+ */
+Vector<DataPointHandle> topKInterned(istream& stream, int k, StringArena& names) {
+    HandleHeap pq;
+    DataPoint point;
+    while (stream >> point) {
+        if (pq.size() < k || (pq.size() != 0 && point.priority > pq.peek().priority)) {
+            offerTopK(pq, internDataPoint(point, names), k);
+        }
+    }
+    return drainDescending(pq);
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("StringArena: same string same id, ids dense and stable across growth") {
+    StringArena arena;
+    EXPECT_EQUAL(arena.find("a"), -1);
+    EXPECT_EQUAL(arena.intern("a"), 0);
+    EXPECT_EQUAL(arena.intern(""), 1);
+    EXPECT_EQUAL(arena.intern("a"), 0);
+    EXPECT_EQUAL(arena.intern(string("x\0y", 3)), 2);
+    EXPECT_EQUAL(arena.lookup(2), string("x\0y", 3));
+
+    for (int i = 0; i < 5000; i++) {
+        EXPECT_EQUAL(arena.intern("name-" + integerToString(i)), 3 + i);
+    }
+    for (int i = 0; i < 5000; i++) {
+        EXPECT_EQUAL(arena.find("name-" + integerToString(i)), 3 + i);
+        EXPECT_EQUAL(arena.lookup(3 + i), "name-" + integerToString(i));
+    }
+    EXPECT_EQUAL(arena.size(), 5003);
+    EXPECT_EQUAL(arena.lookup(1), "");
+    EXPECT_ERROR(arena.lookup(5003));
+    EXPECT_ERROR(arena.lookup(-1));
+}
+
+STUDENT_TEST("HandleHeap dequeues in the same priority order as PQHeap") {
+    HandleHeap handles;
+    PQHeap points;
+    for (int i = 0; i < 1000; i++) {
+        int priority = randomInteger(-100, 100);
+        handles.enqueue({ i, priority });
+        points.enqueue({ "", priority });
+    }
+    EXPECT_EQUAL(handles.size(), 1000);
+    while (!points.isEmpty()) {
+        EXPECT_EQUAL(handles.peek().priority, points.peek().priority);
+        EXPECT_EQUAL(handles.dequeue().priority, points.dequeue().priority);
+    }
+    EXPECT(handles.isEmpty());
+    EXPECT_ERROR(handles.dequeue());
+    EXPECT_ERROR(handles.peek());
+}
+
+STUDENT_TEST("handle pqSort / topK / topKInterned agree with the DataPoint versions") {
+    StringArena names;
+    Vector<DataPoint> points;
+    Vector<DataPointHandle> handles;
+    stringstream stream;
+    for (int i = 0; i < 2000; i++) {
+        DataPoint pt = { "host-" + integerToString(randomInteger(1, 30)), randomInteger(1, 1000000) };
+        points.add(pt);
+        handles.add(internDataPoint(pt, names));
+        stream << pt;
+    }
+    EXPECT(names.size() <= 30);
+
+    Vector<DataPoint> sortedPoints = points;
+    pqSort(sortedPoints);
+    pqSort(handles);
+    for (int i = 0; i < handles.size(); i++) {
+        EXPECT_EQUAL(handles[i].priority, sortedPoints[i].priority);
+    }
+
+    for (int k : { 0, 1, 10, 2000, 3000 }) {
+        Vector<DataPoint> expected = topK(points, k);
+        Vector<DataPointHandle> fromVector = topK(handles, k);
+        stringstream copy(stream.str());
+        StringArena streamNames;
+        Vector<DataPointHandle> fromStream = topKInterned(copy, k, streamNames);
+        EXPECT_EQUAL(fromVector.size(), expected.size());
+        EXPECT_EQUAL(fromStream.size(), expected.size());
+        for (int i = 0; i < expected.size(); i++) {
+            EXPECT_EQUAL(fromVector[i].priority, expected[i].priority);
+            EXPECT_EQUAL(resolve(fromStream[i], streamNames).priority, expected[i].priority);
+            EXPECT(names.find(resolve(fromStream[i], streamNames).name) != -1);
+        }
+    }
+}
+
+/* Helper for the time trial: interns every point of points. */
+static Vector<DataPointHandle> internAll(const Vector<DataPoint>& points, StringArena& names) {
+    Vector<DataPointHandle> handles;
+    for (const DataPoint& pt : points) {
+        handles.add(internDataPoint(pt, names));
+    }
+    return handles;
+}
+
+STUDENT_TEST("pqSort on DataPoints vs interned handles: time trial") {
+    for (int size = 100000; size <= 400000; size *= 2) {
+        Vector<DataPoint> points;
+        for (int i = 0; i < size; i++) {
+            points.add({ "a-longish-service-name-" + integerToString(randomInteger(1, 50)), randomInteger(1, size) });
+        }
+        StringArena names;
+        Vector<DataPointHandle> handles = internAll(points, names);
+        TIME_OPERATION(size, pqSort(points));
+        TIME_OPERATION(size, pqSort(handles));
+        EXPECT(names.bytesUsed() < 50 * 30);
+    }
+}
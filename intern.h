@@ -0,0 +1,134 @@
+/* File: intern.h
+ * Assignment brief: interned DataPoint names. Every DataPoint owns a std::string name, so the
+ * heap and the client functions copy (and often allocate) a string every time they move a
+ * point. When names come from a small vocabulary, each distinct name can instead be stored
+ * once in a StringArena, and points can carry its int id in an 8-byte DataPointHandle. Heap
+ * moves then copy two ints, and reading a stream allocates nothing once the vocabulary
+ * has been seen.
+ */
+#pragma once
+#include "testing/MemoryUtils.h"
+#include "binaryheap.h"
+#include "datapoint.h"
+#include "vector.h"
+#include <istream>
+#include <string>
+
+/**
+ * Stores each distinct string once, packed end to end in one growing char array, and
+ * hands out dense ids 0, 1, 2, ... in the order strings were first interned. Ids stay
+ * valid for the lifetime of the arena. Lookups by content go through an open-addressing
+ * hash table of ids, so interning a string that is already there allocates nothing.
+ */
+class StringArena {
+public:
+    /**
+     * Creates an empty arena.
+     */
+    StringArena();
+
+    /**
+     * Frees the arena's storage. Handles that refer to it can no longer be resolved.
+     */
+    ~StringArena();
+
+    /**
+     * Returns the id of the string data[0 .. length), adding it if it isn't there yet.
+     * Expected time O(length).
+     */
+    int intern(const char* data, int length);
+
+    /**
+     * Convenience for intern(s.data(), s.size()).
+     */
+    int intern(const std::string& s);
+
+    /**
+     * Returns the id of s, or -1 if s has not been interned.
+     */
+    int find(const std::string& s) const;
+
+    /**
+     * Returns the string with the given id.
+     *
+     * Reports an error if id is out of range.
+     */
+    std::string lookup(int id) const;
+
+    /**
+     * Returns the number of distinct strings interned.
+     */
+    int size() const;
+
+    /**
+     * Returns the number of bytes of string data stored (not counting the index).
+     */
+    int bytesUsed() const;
+
+private:
+    char* _bytes;           // every interned string, end to end
+    int _numBytes;
+    int _bytesAllocated;
+    int* _offsets;          // _offsets[id] is where string id starts; _offsets[_numIds] == _numBytes
+    int _numIds;
+    int _idsAllocated;
+    int* _slots;            // hash table of ids, -1 for an empty slot
+    int _numSlots;          // always a power of two
+
+    int findSlot(const char* data, int length, unsigned int hash) const;
+    void growSlots();
+
+    DISALLOW_COPYING_OF(StringArena);
+};
+
+/**
+ * A DataPoint whose name has been interned: nameId is an id in some StringArena.
+ */
+struct DataPointHandle {
+    int nameId;
+    int priority;
+};
+
+bool operator==(const DataPointHandle& lhs, const DataPointHandle& rhs);
+bool operator!=(const DataPointHandle& lhs, const DataPointHandle& rhs);
+std::ostream& operator<<(std::ostream& out, const DataPointHandle& handle);
+
+/**
+ * Interns point's name in names and returns its handle.
+ */
+DataPointHandle internDataPoint(const DataPoint& point, StringArena& names);
+
+/**
+ * Turns a handle back into a DataPoint using the arena it came from.
+ */
+DataPoint resolve(const DataPointHandle& handle, const StringArena& names);
+
+/**
+ * Returns handle's priority, for ordering handles in a BinaryHeap.
+ */
+inline int handlePriority(const DataPointHandle& handle) {
+    return handle.priority;
+}
+
+/**
+ * Priority queue of DataPointHandles, the same binary min-heap by priority as PQHeap.
+ */
+typedef BinaryHeap<DataPointHandle, handlePriority> HandleHeap;
+
+/**
+ * Handle version of pqSort: sorts v in increasing order of priority using a HandleHeap.
+ */
+void pqSort(Vector<DataPointHandle>& v);
+
+/**
+ * Handle version of topK(const Vector<DataPoint>&, int): returns the k handles of v with
+ * the highest priority, sorted in descending order of priority.
+ */
+Vector<DataPointHandle> topK(const Vector<DataPointHandle>& v, int k);
+
+/**
+ * Same as topK(std::istream&, int), but interns every name into names and keeps handles
+ * in the heap. Each point is parsed into the same DataPoint, so its name buffer is reused
+ * and, once the vocabulary has been seen, the stream is read without allocating.
+ */
+Vector<DataPointHandle> topKInterned(std::istream& stream, int k, StringArena& names);
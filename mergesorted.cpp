@@ -0,0 +1,183 @@
+/* File: mergesorted.cpp
+ * Assignment brief: heap-driven k-way merge of DataPoint streams that are already sorted,
+ * without re-sorting them. The header file, "mergesorted.h" is in this repository.
+ */
+#include "mergesorted.h"
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include <sstream>
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/*
+ * The heap holds a priority and a source index per source, so the merge never copies a
+ * name or makes a string per element. The real head elements are kept in _heads.
+ */
+SortedMergeCursor::SortedMergeCursor(const Vector<DataPointSource>& sources) {
+    _sources = sources;
+    _heads = Vector<DataPoint>(sources.size());
+    for (int i = 0; i < _sources.size(); i++) {
+        if (_sources[i](_heads[i])) {
+            _pq.enqueue({ _heads[i].priority, i });
+        }
+    }
+}
+
+/* HELPER FUNCTION: wraps each stream as a DataPointSource. */
+static Vector<DataPointSource> streamSources(const Vector<istream*>& streams) {
+    Vector<DataPointSource> sources;
+    for (istream* stream : streams) {
+        sources.add([stream](DataPoint& point) { return (bool) (*stream >> point); });
+    }
+    return sources;
+}
+
+SortedMergeCursor::SortedMergeCursor(const Vector<istream*>& streams)
+    : SortedMergeCursor(streamSources(streams)) {
+}
+
+/* HELPER FUNCTION: reads the next head of source into _heads and puts it in the heap,
+ * checking that the source really is sorted.
+ */
+void SortedMergeCursor::advance(int source) {
+    int previous = _heads[source].priority;
+    if (_sources[source](_heads[source])) {
+        if (_heads[source].priority < previous) {
+            error("mergeSorted: input " + integerToString(source) + " is not sorted");
+        }
+        _pq.enqueue({ _heads[source].priority, source });
+    }
+}
+
+bool SortedMergeCursor::next(DataPoint& point) {
+    if (_pq.isEmpty()) {
+        return false;
+    }
+    int source = _pq.dequeue().source;
+    point = _heads[source];
+    advance(source);
+    return true;
+}
+
+void mergeSorted(const Vector<istream*>& streams, DataPointSink callback) {
+    SortedMergeCursor cursor(streams);
+    DataPoint point;
+    while (cursor.next(point)) {
+        callback(point);
+    }
+}
+
+void mergeSorted(const Vector<istream*>& streams, ostream& out) {
+    mergeSorted(streams, [&](const DataPoint& point) { out << point; });
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+/* Helper function that makes m sorted text streams of random lengths, and also returns
+ * every element in all of them.
+ */
+static Vector<stringstream*> sortedStreams(int m, int maxLength, Vector<DataPoint>& all) {
+    Vector<stringstream*> streams;
+    for (int i = 0; i < m; i++) {
+        Vector<DataPoint> points;
+        int length = randomInteger(0, maxLength);
+        for (int j = 0; j < length; j++) {
+            points.add({ "s" + integerToString(i), randomInteger(-100000, 100000) });
+        }
+        pqSort(points);
+        stringstream* stream = new stringstream;
+        for (const DataPoint& pt : points) {
+            *stream << pt;
+            all.add(pt);
+        }
+        streams.add(stream);
+    }
+    return streams;
+}
+
+STUDENT_TEST("mergeSorted merges sorted streams into one sorted stream") {
+    for (int m : { 1, 2, 7, 100 }) {
+        Vector<DataPoint> all;
+        Vector<stringstream*> streams = sortedStreams(m, 300, all);
+        Vector<istream*> inputs;
+        for (stringstream* stream : streams) {
+            inputs.add(stream);
+        }
+
+        Vector<DataPoint> merged;
+        mergeSorted(inputs, [&](const DataPoint& point) { merged.add(point); });
+        pqSort(all);
+        EXPECT_EQUAL(merged.size(), all.size());
+        for (int i = 0; i < merged.size(); i++) {
+            EXPECT_EQUAL(merged[i].priority, all[i].priority);
+        }
+        for (stringstream* stream : streams) {
+            delete stream;
+        }
+    }
+}
+
+STUDENT_TEST("mergeSorted ostream version, cursor version, and unsorted input") {
+    stringstream a, b, out, expected;
+    a << DataPoint{ "A", 1 } << DataPoint{ "A", 4 };
+    b << DataPoint{ "B", 2 } << DataPoint{ "B", 3 } << DataPoint{ "B", 5 };
+    mergeSorted({ &a, &b }, out);
+    expected << DataPoint{ "A", 1 } << DataPoint{ "B", 2 } << DataPoint{ "B", 3 }
+             << DataPoint{ "A", 4 } << DataPoint{ "B", 5 };
+    EXPECT_EQUAL(out.str(), expected.str());
+
+    Vector<DataPoint> left = { { "L", 0 }, { "L", 10 } };
+    int next = 0;
+    DataPointSource fromVector = [&](DataPoint& point) {
+        if (next == left.size()) return false;
+        point = left[next++];
+        return true;
+    };
+    stringstream right;
+    right << DataPoint{ "R", 5 };
+    SortedMergeCursor cursor({ fromVector, [&](DataPoint& point) { return (bool) (right >> point); } });
+    DataPoint point;
+    Vector<int> order;
+    while (cursor.next(point)) {
+        order.add(point.priority);
+    }
+    EXPECT_EQUAL(order, Vector<int>({ 0, 5, 10 }));
+
+    stringstream unsorted;
+    unsorted << DataPoint{ "U", 2 } << DataPoint{ "U", 1 };
+    EXPECT_ERROR(mergeSorted({ &unsorted }, out));
+    EXPECT_NO_ERROR(mergeSorted({}, out));
+}
+
+/* Helper function for the time trial below: concatenate then pqSort. */
+static void concatenateAndSort(const Vector<istream*>& streams) {
+    Vector<DataPoint> all;
+    DataPoint point;
+    for (istream* stream : streams) {
+        while (*stream >> point) {
+            all.add(point);
+        }
+    }
+    pqSort(all);
+}
+
+STUDENT_TEST("mergeSorted vs concatenate + pqSort: time trial, 16 streams, varying n") {
+    for (int perStream = 10000; perStream <= 40000; perStream *= 2) {
+        Vector<DataPoint> all;
+        Vector<stringstream*> streams = sortedStreams(16, 2 * perStream, all);
+        Vector<istream*> inputs, copies;
+        for (stringstream* stream : streams) {
+            inputs.add(stream);
+            copies.add(new stringstream(stream->str()));
+        }
+        int count = 0;
+        TIME_OPERATION(all.size(), mergeSorted(inputs, [&](const DataPoint&) { count++; }));
+        TIME_OPERATION(all.size(), concatenateAndSort(copies));
+        for (int i = 0; i < streams.size(); i++) {
+            delete streams[i];
+            delete copies[i];
+        }
+    }
+}
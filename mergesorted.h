@@ -0,0 +1,77 @@
+/* File: mergesorted.h
+ * Assignment brief: heap-driven k-way merge of DataPoint streams that are already sorted,
+ * without re-sorting them.
+ */
+#pragma once
+#include "testing/MemoryUtils.h"
+#include "binaryheap.h"
+#include "datapoint.h"
+#include "pqclient.h"
+#include "vector.h"
+#include <istream>
+#include <ostream>
+
+/**
+ * Heap entry for one source in the merge: the priority of its head element and the index
+ * of the source it came from.
+ */
+struct MergeHead {
+    int priority;
+    int source;
+};
+
+/**
+ * Returns head's priority, for ordering merge heads in a BinaryHeap.
+ */
+inline int mergeHeadPriority(const MergeHead& head) {
+    return head.priority;
+}
+
+/**
+ * Cursor over the merge of m sorted sources. It keeps one head element per source and a
+ * binary min-heap of those heads, so each next() costs O(log m), and memory is O(m) no
+ * matter how long the sources are.
+ */
+class SortedMergeCursor {
+public:
+    /**
+     * Creates a cursor over sources, each of which must produce DataPoints in increasing
+     * order of weight.
+     */
+    SortedMergeCursor(const Vector<DataPointSource>& sources);
+
+    /**
+     * Creates a cursor over text-format streams (read with operator>>), each of which must
+     * be sorted in increasing order of weight.
+     */
+    SortedMergeCursor(const Vector<std::istream*>& streams);
+
+    /**
+     * Fills in point with the smallest remaining element of all the sources and returns
+     * true, or returns false when every source is used up. Can be used directly as a
+     * DataPointSource.
+     *
+     * Reports an error if a source produces an element smaller than its previous one.
+     */
+    bool next(DataPoint& point);
+
+private:
+    Vector<DataPointSource> _sources;
+    Vector<DataPoint> _heads;   // current head element of each source
+    BinaryHeap<MergeHead, mergeHeadPriority> _pq;   // one entry per non-empty source
+
+    void advance(int source);
+
+    DISALLOW_COPYING_OF(SortedMergeCursor);
+};
+
+/**
+ * Merges sorted text-format streams and passes the merged elements, in increasing order of
+ * weight, to callback. Runs in time O(n log m) and memory O(m) for n elements in m streams.
+ */
+void mergeSorted(const Vector<std::istream*>& streams, DataPointSink callback);
+
+/**
+ * Merges sorted text-format streams and writes the merged elements to out with operator<<.
+ */
+void mergeSorted(const Vector<std::istream*>& streams, std::ostream& out);
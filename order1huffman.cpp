@@ -0,0 +1,315 @@
+/* File: order1huffman.cpp
+ * Assignment brief: order-1 context-modeled Huffman coding. The header file,
+ * "order1huffman.h" is in this repository, along with a description of the layout.
+ */
+#include "order1huffman.h"
+#include "byteio.h"
+#include "canonical.h"
+#include "error.h"
+#include "filelib.h"
+#include "huffmanbuild.h"
+#include "random.h"
+#include "strlib.h"
+#include <algorithm>
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/* HELPER FUNCTION: returns the bits that counts cost when coded with lengths. */
+static int64_t codedBits(const int64_t counts[256], const uint8_t lengths[256]) {
+    int64_t bits = 0;
+    for (int b = 0; b < 256; b++) {
+        bits += counts[b] * lengths[b];
+    }
+    return bits;
+}
+
+/*
+ * Every context is weighed against the order-0 code, not against the shared table it
+ * would fall into, since that table isn't known until the choices are made. The shared
+ * table is then built from exactly the contexts left over, so it codes all of them.
+ */
+void buildOrder1Tables(const string& text, Order1Tables& tables) {
+    vector<int64_t> pairCounts(256 * 256, 0);
+    const unsigned char* bytes = (const unsigned char*) text.data();
+    unsigned char previous = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        pairCounts[previous * 256 + bytes[i]]++;
+        previous = bytes[i];
+    }
+    int64_t counts[256];
+    countBytes(text, counts);
+    uint8_t order0[256] = { 0 };
+    if (!text.empty()) {
+        limitedCodeLengthsFromCounts(counts, kDefaultCodeLengthLimit, order0);
+    }
+
+    tables.lengths.assign(1, array<uint8_t, 256>());
+    int64_t sharedCounts[256] = { 0 };
+    for (int context = 0; context < 256; context++) {
+        const int64_t* contextCounts = &pairCounts[context * 256];
+        tables.tableOf[context] = 0;
+        if (*max_element(contextCounts, contextCounts + 256) == 0) {
+            continue;
+        }
+        array<uint8_t, 256> own;
+        limitedCodeLengthsFromCounts(contextCounts, kDefaultCodeLengthLimit, own.data());
+        int64_t ownBits = codedBits(contextCounts, own.data()) + 8 * packCodeLengths(own.data()).size();
+        if (ownBits < codedBits(contextCounts, order0)) {
+            tables.tableOf[context] = tables.lengths.size();
+            tables.lengths.push_back(own);
+        }
+        else {
+            for (int b = 0; b < 256; b++) {
+                sharedCounts[b] += contextCounts[b];
+            }
+        }
+    }
+    tables.lengths[0].fill(0);
+    if (*max_element(sharedCounts, sharedCounts + 256) > 0) {
+        limitedCodeLengthsFromCounts(sharedCounts, kDefaultCodeLengthLimit, tables.lengths[0].data());
+    }
+}
+
+Order1Decoder::Order1Decoder(const Order1Tables& tables) {
+    vector<int> tableOffset;
+    vector<int> tableShift;
+    for (const array<uint8_t, 256>& lengths : tables.lengths) {
+        uint64_t codes[256];
+        canonicalCodes(lengths.data(), codes);
+        int longest = *max_element(lengths.begin(), lengths.end());
+        if (longest > kDefaultCodeLengthLimit) {
+            error("Order1Decoder: code longer than kDefaultCodeLengthLimit");
+        }
+        int width = max(1, longest);
+        int offset = _entries.size();
+        tableOffset.push_back(offset);
+        tableShift.push_back(64 - width);
+        _entries.resize(offset + (1 << width), { 0, 0 });
+        for (int b = 0; b < 256; b++) {
+            if (lengths[b] > 0) {
+                int span = width - lengths[b];
+                for (uint32_t i = 0; i < (1u << span); i++) {
+                    _entries[offset + (codes[b] << span) + i] = { (uint8_t) b, lengths[b] };
+                }
+            }
+        }
+    }
+    for (int context = 0; context < 256; context++) {
+        int table = tables.tableOf[context];
+        if (table >= (int) tables.lengths.size()) {
+            error("Order1Decoder: context uses a missing table");
+        }
+        _offset[context] = tableOffset[table];
+        _shift[context] = tableShift[table];
+    }
+}
+
+/*
+ * Same word reads as CanonicalDecoder::decodeInterleaved: the bits' words are read in
+ * place, and before the last word the next 64 bits are two whole words with no bounds
+ * checks. In the last word, words past the end read as zeros. Each step is one lookup in
+ * the table its context picks, and the decoded byte is the next step's context.
+ */
+string Order1Decoder::decode(const BitBuffer& bits, int64_t length) const {
+    const uint64_t* base = bits.words().data();
+    int64_t numWords = bits.words().size();
+    int64_t limit = (numWords - 1) * 64;
+    const Entry* entries = _entries.data();
+    int64_t end = bits.size();
+    auto wordAt = [&](int64_t w) -> uint64_t {
+        return (w < numWords) ? base[w] : 0;
+    };
+
+    string msg(length, '\0');
+    char* out = &msg[0];
+    int64_t pos = 0;
+    unsigned char context = 0;
+    for (int64_t i = 0; i < length; i++) {
+        uint64_t window;
+        if (pos < limit) {
+            window = base[pos >> 6] << (pos & 63);
+            window |= (base[(pos >> 6) + 1] >> 1) >> (63 - (pos & 63));
+        }
+        else {
+            window = wordAt(pos >> 6) << (pos & 63);
+            window |= (wordAt((pos >> 6) + 1) >> 1) >> (63 - (pos & 63));
+        }
+        Entry entry = entries[_offset[context] + (window >> _shift[context])];
+        if (entry.length == 0) {
+            error("Order1Decoder: bits do not form a code");
+        }
+        pos += entry.length;
+        if (pos > end) {
+            error("Order1Decoder: message bits end in the middle of a code");
+        }
+        out[i] = entry.symbol;
+        context = entry.symbol;
+    }
+    if (pos != end) {
+        error("Order1Decoder: message bits do not end after the last code");
+    }
+    return msg;
+}
+
+/*
+ * Each byte is written through BitWriter with its code in the table of its context.
+ */
+string compressOrder1(const string& messageText) {
+    string out;
+    appendVarint(out, messageText.size());
+    if (messageText.empty()) {
+        return out;
+    }
+    Order1Tables tables;
+    buildOrder1Tables(messageText, tables);
+
+    string bitmap(32, '\0');
+    for (int context = 0; context < 256; context++) {
+        if (tables.tableOf[context] > 0) {
+            bitmap[context / 8] |= (char) (1 << (context % 8));
+        }
+    }
+    out += bitmap;
+    vector<array<uint64_t, 256>> codes(tables.lengths.size());
+    for (size_t table = 0; table < tables.lengths.size(); table++) {
+        out += packCodeLengths(tables.lengths[table].data());
+        canonicalCodes(tables.lengths[table].data(), codes[table].data());
+    }
+
+    BitBuffer bits;
+    BitWriter writer(bits);
+    const unsigned char* bytes = (const unsigned char*) messageText.data();
+    unsigned char context = 0;
+    for (size_t i = 0; i < messageText.size(); i++) {
+        int table = tables.tableOf[context];
+        writer.write(codes[table][bytes[i]], tables.lengths[table][bytes[i]]);
+        context = bytes[i];
+    }
+    writer.flush();
+    appendVarint(out, bits.size());
+    bits.appendBytes(out);
+    return out;
+}
+
+/*
+ * Every code is at least one bit, so a message longer than its bit count is rejected
+ * before the output is allocated.
+ */
+string decompressOrder1(const string& bytes) {
+    size_t pos = 0;
+    uint64_t length = readVarint(bytes.data(), bytes.size(), pos);
+    if (length == 0) {
+        if (pos != bytes.size()) {
+            error("decompressOrder1: extra bytes after the message");
+        }
+        return "";
+    }
+    if (bytes.size() - pos < 32) {
+        error("decompressOrder1: truncated context bitmap");
+    }
+    size_t bitmap = pos;
+    pos += 32;
+    Order1Tables tables;
+    tables.lengths.assign(1, array<uint8_t, 256>());
+    unpackCodeLengths(bytes, pos, tables.lengths[0].data());
+    for (int context = 0; context < 256; context++) {
+        tables.tableOf[context] = 0;
+        if ((bytes[bitmap + context / 8] >> (context % 8)) & 1) {
+            tables.tableOf[context] = tables.lengths.size();
+            tables.lengths.push_back(array<uint8_t, 256>());
+            unpackCodeLengths(bytes, pos, tables.lengths.back().data());
+        }
+    }
+    uint64_t numBits = readVarint(bytes.data(), bytes.size(), pos);
+    if (numBits > (uint64_t) (bytes.size() - pos) * 8 || (numBits + 7) / 8 != bytes.size() - pos) {
+        error("decompressOrder1: message length does not match");
+    }
+    if (length > numBits) {
+        error("decompressOrder1: message is longer than its bits allow");
+    }
+    BitBuffer bits = BitBuffer::fromBytes(bytes.data() + pos, numBits);
+    Order1Decoder decoder(tables);
+    return decoder.decode(bits, length);
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * */
+
+STUDENT_TEST("compressOrder1 -> decompressOrder1 end to end, including edge cases") {
+    for (string file : { "res/constitution.txt", "res/dream.txt" }) {
+        string text = readEntireFile(file);
+        EXPECT_EQUAL(decompressOrder1(compressOrder1(text)), text);
+    }
+    string every;
+    for (int b = 0; b < 256; b++) {
+        every += string(b % 5 + 1, (char) b) + (char) (255 - b);
+    }
+    for (string text : { string(""), string("a"), string(50, 'q'), string("ab"), string("abababab"), every }) {
+        EXPECT_EQUAL(decompressOrder1(compressOrder1(text)), text);
+    }
+
+    string bytes = compressOrder1(readEntireFile("res/dream.txt"));
+    EXPECT_ERROR(decompressOrder1(bytes.substr(0, bytes.size() - 1)));
+    EXPECT_ERROR(decompressOrder1(bytes + "x"));
+    EXPECT_ERROR(decompressOrder1(bytes.substr(0, 20)));
+    EXPECT_ERROR(decompressOrder1(compressOrder1("") + "x"));
+    string longer = bytes;
+    longer[0] = (char) ((unsigned char) longer[0] + 1);   // one more character than coded
+    EXPECT_ERROR(decompressOrder1(longer));
+}
+
+STUDENT_TEST("buildOrder1Tables: busy contexts get their own table, sparse ones share") {
+    // after 'q' always 'u': that context's own table is a single 1-bit code
+    string text;
+    for (int i = 0; i < 2000; i++) {
+        text += "quiet queen quota ";
+    }
+    text += "xyz";
+    Order1Tables tables;
+    buildOrder1Tables(text, tables);
+    int q = tables.tableOf[(unsigned char) 'q'];
+    EXPECT(q > 0);
+    EXPECT_EQUAL(tables.lengths[q][(unsigned char) 'u'], 1);
+    EXPECT_EQUAL(tables.tableOf[(unsigned char) 'x'], 0);  // seen once: shares table 0
+    EXPECT(tables.lengths[0][(unsigned char) 'y'] > 0);
+    EXPECT_EQUAL(tables.tableOf[(unsigned char) 'A'], 0);  // never seen
+
+    // bytes with no dependence on the one before: no context pays for a header, so the
+    // output is the order-0 code plus the length, the bitmap and one header
+    string noise;
+    for (int i = 0; i < 100000; i++) {
+        noise += (char) randomInteger(0, 255);
+    }
+    buildOrder1Tables(noise, tables);
+    EXPECT_EQUAL((int) tables.lengths.size(), 1);
+    int64_t order0 = serializeCanonical(compressCanonical(noise)).size();
+    EXPECT((int64_t) compressOrder1(noise).size() <= order0 + 40);
+}
+
+STUDENT_TEST("Order-1 vs order-0: compression ratio and throughput") {
+    for (string file : { "res/constitution.txt", "res/dream.txt" }) {
+        string base = readEntireFile(file);
+        Order1Tables tables;
+        buildOrder1Tables(base, tables);
+        int64_t order0 = serializeCanonical(compressCanonical(base)).size();
+        int64_t order1 = compressOrder1(base).size();
+        cout << "    " << file << ", " << base.size() << " bytes:" << endl;
+        cout << "      order-0: " << order0 << " bytes (" << 8.0 * order0 / base.size() << " bits/byte)" << endl;
+        cout << "      order-1: " << order1 << " bytes (" << 8.0 * order1 / base.size() << " bits/byte), "
+             << tables.lengths.size() - 1 << " contexts with their own table" << endl;
+        EXPECT(order1 < order0);
+
+        string text;
+        while (text.size() < (16 << 20)) {
+            text += base;
+        }
+        string canonical, contextual, fromCanonical, fromOrder1;
+        TIME_OPERATION(text.size(), canonical = serializeCanonical(compressCanonical(text)));
+        TIME_OPERATION(text.size(), contextual = compressOrder1(text));
+        TIME_OPERATION(text.size(), fromCanonical = decompressCanonical(deserializeCanonical(canonical)));
+        TIME_OPERATION(text.size(), fromOrder1 = decompressOrder1(contextual));
+        EXPECT(fromCanonical == text);
+        EXPECT(fromOrder1 == text);
+        cout << "      sizes: order-0 " << canonical.size() << ", order-1 " << contextual.size() << endl;
+    }
+}
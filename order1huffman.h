@@ -0,0 +1,82 @@
+/* File: order1huffman.h
+ * Assignment brief: order-1 context-modeled Huffman coding. compress codes every byte with
+ * one tree. Here the code for a byte depends on the byte before it (its context), so in
+ * text a 'q' is followed by a short code for 'u'. A context seen often enough to pay for
+ * its own code-length header gets its own table; all the others share one table built
+ * from their combined counts, so rare contexts cost no header at all.
+ *
+ * Layout (varints as in byteio.h):
+ *
+ *     message := length [contextBitmap sharedLengths ownLengths* numBits bits]
+ *
+ * The rest is left out when length is 0. contextBitmap is 32 bytes with bit c set when
+ * context c has its own table; bit c of byte c / 8 is (1 << c % 8). Each *Lengths is a
+ * packCodeLengths header (see canonical.h), with ownLengths in increasing context order.
+ * The first byte is coded in context 0, and bits are packed 8 to a byte.
+ */
+#pragma once
+#include "testing/MemoryUtils.h"
+#include "bitbuffer.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Code lengths of an order-1 model. Table 0 is the shared table; contexts with their own
+ * table use tables 1, 2, ... in increasing context order. No code is longer than
+ * kDefaultCodeLengthLimit bits.
+ */
+struct Order1Tables {
+    uint8_t tableOf[256];                           // table used after each byte value
+    std::vector<std::array<uint8_t, 256>> lengths;  // code lengths of each table
+};
+
+/**
+ * Builds the order-1 model for text. A context gets its own table when the bits it saves
+ * over the order-0 code of the whole text are more than the bits of its header.
+ */
+void buildOrder1Tables(const std::string& text, Order1Tables& tables);
+
+/**
+ * Table-driven decoder for order-1 codes. Every table is resolved with a single lookup,
+ * in a table as wide as its longest code, and the context of each step picks the table.
+ */
+class Order1Decoder {
+public:
+    /**
+     * Reports an error if a table is not a prefix code, or has a code longer than
+     * kDefaultCodeLengthLimit bits.
+     */
+    Order1Decoder(const Order1Tables& tables);
+
+    /**
+     * Decodes a message of length characters from bits.
+     *
+     * Reports an error on a bit pattern that isn't a code in its context, or if the bits
+     * do not end exactly after the last code.
+     */
+    std::string decode(const BitBuffer& bits, int64_t length) const;
+
+private:
+    struct Entry {
+        uint8_t symbol;
+        uint8_t length;     // 0 if not a code
+    };
+
+    std::vector<Entry> _entries;    // every table's entries, one after another
+    int _offset[256];               // where the table of each context starts in _entries
+    int _shift[256];                // 64 - width of that table
+};
+
+/**
+ * Order-1 Huffman-codes messageText. Any text is allowed, including the empty string.
+ */
+std::string compressOrder1(const std::string& messageText);
+
+/**
+ * Inverse of compressOrder1.
+ *
+ * Reports an error if bytes is truncated, malformed, or has extra bytes at the end.
+ */
+std::string decompressOrder1(const std::string& bytes);
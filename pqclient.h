@@ -1,10 +1,24 @@
 #pragma once
 
 #include "datapoint.h"
+#include "pqheap.h"
 #include "vector.h"
+#include <functional>
 #include <istream>
 
 
+/**
+ * A function that produces DataPoints one at a time. It fills in its argument and
+ * returns true, or returns false once there are no more.
+ */
+typedef std::function<bool(DataPoint&)> DataPointSource;
+
+/**
+ * A function that receives DataPoints one at a time.
+ */
+typedef std::function<void(const DataPoint&)> DataPointSink;
+
+
 /**
  * This function sorts a Vector of DataPoints by storing them
  * all in a PQueue and then extracting them all, which gives the
@@ -38,3 +52,80 @@ void pqSort(Vector<DataPoint>& v);
  *         order of weight, where n is the number of items in the stream.
  */
 Vector<DataPoint> topK(std::istream& stream, int k);
+
+
+/**
+ * In-memory version of topK: returns the k elements of v with the highest weight, sorted
+ * in descending order of weight. v is not modified.
+ *
+ * When k is a small fraction of v.size(), this uses a size-k PQHeap in time O(n log k).
+ * When k is a large fraction, the heap does nearly as much work as a full sort, so this
+ * instead partitions the top k to the front with introselect (std::nth_element) in O(n)
+ * and sorts only those k elements, in time O(n + k log k). The switch happens at
+ * kSelectCrossover, which was picked from the time trial in pqclient.cpp.
+ *
+ * @param v The data points to choose from.
+ * @param k The number of elements to return.
+ * @return The min{n, k} data points of v with the highest weight, sorted in descending
+ *         order of weight.
+ */
+Vector<DataPoint> topK(const Vector<DataPoint>& v, int k);
+
+
+/**
+ * Settings for topKPipelined.
+ */
+struct PipelineOptions {
+    int batchSize = 1024;   // DataPoints parsed per batch handed from the parser thread
+    int ringCapacity = 8;   // batches in flight; the parser waits when all are full
+};
+
+/**
+ * Pipelined version of topK. A parser thread reads DataPoints from the stream (stream >> point)
+ * into batches in a lock-free single-producer / single-consumer ring, while the calling
+ * thread keeps the size-k PQHeap up to date from the batches. Parsing and I/O
+ * overlap with heap work. The parser blocks when ringCapacity batches are waiting (this is
+ * the backpressure), so memory use stays at ringCapacity * batchSize DataPoints.
+ *
+ * Returns the same result as topK(stream, k).
+ *
+ * Reports an error if batchSize or ringCapacity is not positive.
+ */
+Vector<DataPoint> topKPipelined(std::istream& stream, int k, const PipelineOptions& options = PipelineOptions());
+
+/**
+ * Helper shared by the topK variants. Treats pq as a min-heap that holds at most k
+ * elements: element is added if there is room, or if it beats the lowest priority
+ * currently in pq (which is then removed). Runs in time O(log k).
+ *
+ * pq can be a PQHeap or any heap with the same interface, such as a BinaryHeap.
+ * The root of the min-heap is the weakest of the k kept so far, so a new element only
+ * gets in if it beats the root.
+ */
+template <typename Heap, typename Element>
+void offerTopK(Heap& pq, const Element& element, int k) {
+    if (pq.size() < k) {
+        pq.enqueue(element);
+    }
+    else if (pq.size() != 0 && element.priority > pq.peek().priority) {
+        pq.dequeue();
+        pq.enqueue(element);
+    }
+}
+
+/**
+ * Helper shared by the topK variants. Removes every element from pq and returns them
+ * sorted in descending order of weight. Runs in time O(k log k).
+ *
+ * The heap gives elements in increasing priority value, so the result is filled from
+ * the back.
+ */
+template <typename Heap>
+auto drainDescending(Heap& pq) {
+    int size = pq.size();
+    Vector<decltype(pq.dequeue())> result(size);
+    for (int i = size - 1; i >= 0; i--) {
+        result[i] = pq.dequeue();
+    }
+    return result;
+}
@@ -0,0 +1,400 @@
+/* File: quantiles.cpp
+ * Assignment brief: streaming median / quantile estimators over DataPoint priorities, using a
+ * pair of PQHeaps instead of re-sorting with pqSort for every query. The header file,
+ * "quantiles.h" is in this repository.
+ */
+#include "quantiles.h"
+#include "pqclient.h"
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include "vector.h"
+#include <algorithm>
+#include <cmath>
+#include "testing/SimpleTest.h"
+using namespace std;
+
+/* HELPER FUNCTION: nearest-rank position of the q-quantile among n values, at least 1.
+ * The small epsilon keeps products like 0.3 * 10 = 3.0000000000000004 from rounding up.
+ */
+static int quantileRank(double q, int n) {
+    return max(1, (int) ceil(q * n - 1e-9));
+}
+
+RunningQuantile::RunningQuantile(double q) {
+    if (q < 0 || q > 1) {
+        error("RunningQuantile: q must be between 0 and 1");
+    }
+    _q = q;
+}
+
+/*
+ * Values no bigger than the current answer go into the low (max) heap, the rest into the
+ * high (min) heap. Then rebalance moves at most one value across to restore the rank.
+ */
+void RunningQuantile::add(int priority) {
+    if (_low.isEmpty() || priority <= ~_low.peek().priority) {
+        _low.enqueue({ "", ~priority });
+    }
+    else {
+        _high.enqueue({ "", priority });
+    }
+    rebalance();
+}
+
+void RunningQuantile::add(const DataPoint& point) {
+    add(point.priority);
+}
+
+/* HELPER FUNCTION: moves values between the heaps until the low heap holds exactly the
+ * smallest quantileRank(q, n) values.
+ */
+void RunningQuantile::rebalance() {
+    int rank = quantileRank(_q, size());
+    while (_low.size() > rank) {
+        _high.enqueue({ "", ~_low.dequeue().priority });
+    }
+    while (_low.size() < rank && !_high.isEmpty()) {
+        _low.enqueue({ "", ~_high.dequeue().priority });
+    }
+}
+
+int RunningQuantile::quantile() const {
+    if (_low.isEmpty()) {
+        error("RunningQuantile: no values added");
+    }
+    return ~_low.peek().priority;
+}
+
+int RunningQuantile::size() const {
+    return _low.size() + _high.size();
+}
+
+SlidingWindowQuantile::SlidingWindowQuantile(double q, int windowSize) {
+    if (q < 0 || q > 1 || windowSize <= 0) {
+        error("SlidingWindowQuantile: q must be between 0 and 1 and windowSize positive");
+    }
+    _q = q;
+    _windowSize = windowSize;
+    _lowSize = 0;
+    _highSize = 0;
+}
+
+/* HELPER FUNCTION: pops deleted values off the top of heap until the top is live. negated
+ * says whether heap stores ~priority (the low heap) or priority (the high heap).
+ */
+void SlidingWindowQuantile::prune(PQHeap& heap, HashMap<int, int>& pending, bool negated) {
+    while (!heap.isEmpty()) {
+        int top = negated ? ~heap.peek().priority : heap.peek().priority;
+        if (pending.get(top) == 0) {
+            break;
+        }
+        pending[top]--;
+        heap.dequeue();
+    }
+}
+
+/* HELPER FUNCTION: lazily deletes one copy of priority. Every live value in the high heap
+ * is at least the top of the low heap, so a value no bigger than that top must be in the
+ * low heap (or is equal to one there, which comes to the same thing).
+ */
+void SlidingWindowQuantile::remove(int priority) {
+    if (_lowSize > 0 && priority <= ~_low.peek().priority) {
+        _pendingLow[priority]++;
+        _lowSize--;
+        prune(_low, _pendingLow, true);
+    }
+    else {
+        _pendingHigh[priority]++;
+        _highSize--;
+        prune(_high, _pendingHigh, false);
+    }
+}
+
+/* HELPER FUNCTION: same as RunningQuantile::rebalance, but counting only live values and
+ * pruning after every move so both tops stay live.
+ */
+void SlidingWindowQuantile::rebalance() {
+    int rank = quantileRank(_q, size());
+    while (_lowSize > rank) {
+        int moved = ~_low.dequeue().priority;
+        _lowSize--;
+        prune(_low, _pendingLow, true);
+        _high.enqueue({ "", moved });
+        _highSize++;
+    }
+    while (_lowSize < rank && _highSize > 0) {
+        int moved = _high.dequeue().priority;
+        _highSize--;
+        prune(_high, _pendingHigh, false);
+        _low.enqueue({ "", ~moved });
+        _lowSize++;
+    }
+}
+
+/* HELPER FUNCTION: throws away both heaps, including any deleted values still buried in
+ * them, and refills them from the window. Called only after at least windowSize
+ * deletions have piled up, so the cost is amortized O(log windowSize) per update.
+ */
+void SlidingWindowQuantile::rebuild() {
+    _low.clear();
+    _high.clear();
+    _pendingLow.clear();
+    _pendingHigh.clear();
+    _lowSize = 0;
+    _highSize = 0;
+    for (int i = 0; i < _window.size(); i++) {
+        int value = _window.dequeue();
+        _window.enqueue(value);
+        _high.enqueue({ "", value });
+        _highSize++;
+    }
+    rebalance();
+}
+
+void SlidingWindowQuantile::add(int priority) {
+    if (_window.size() == _windowSize) {
+        remove(_window.dequeue());
+    }
+    _window.enqueue(priority);
+    if (_lowSize == 0 || priority <= ~_low.peek().priority) {
+        _low.enqueue({ "", ~priority });
+        _lowSize++;
+    }
+    else {
+        _high.enqueue({ "", priority });
+        _highSize++;
+    }
+    rebalance();
+
+    if (_low.size() + _high.size() > 2 * _windowSize) {
+        rebuild();
+    }
+}
+
+int SlidingWindowQuantile::quantile() const {
+    if (_lowSize == 0) {
+        error("SlidingWindowQuantile: no values added");
+    }
+    return ~_low.peek().priority;
+}
+
+int SlidingWindowQuantile::size() const {
+    return _lowSize + _highSize;
+}
+
+/* HELPER FUNCTION: insertion sort for the five (or fewer) marker values. */
+static void sortSmall(double* values, int count) {
+    for (int i = 1; i < count; i++) {
+        double value = values[i];
+        int j = i - 1;
+        while (j >= 0 && values[j] > value) {
+            values[j + 1] = values[j];
+            j--;
+        }
+        values[j + 1] = value;
+    }
+}
+
+P2Quantile::P2Quantile(double q) {
+    if (q <= 0 || q >= 1) {
+        error("P2Quantile: q must be strictly between 0 and 1");
+    }
+    _q = q;
+    _count = 0;
+    double desired[5] = { 1, 1 + 2 * q, 1 + 4 * q, 3 + 2 * q, 5 };
+    double increments[5] = { 0, q / 2, q, (1 + q) / 2, 1 };
+    for (int i = 0; i < 5; i++) {
+        _positions[i] = i + 1;
+        _desired[i] = desired[i];
+        _increments[i] = increments[i];
+    }
+}
+
+/* HELPER FUNCTION: piecewise-parabolic prediction of marker i's height after moving it
+ * one position in direction (+1 or -1).
+ */
+double P2Quantile::parabolic(int i, int direction) const {
+    double d = direction;
+    const double* n = _positions;
+    const double* h = _heights;
+    return h[i] + d / (n[i + 1] - n[i - 1]) *
+           ((n[i] - n[i - 1] + d) * (h[i + 1] - h[i]) / (n[i + 1] - n[i]) +
+            (n[i + 1] - n[i] - d) * (h[i] - h[i - 1]) / (n[i] - n[i - 1]));
+}
+
+/* HELPER FUNCTION: linear fallback when the parabola would leave marker i out of order. */
+double P2Quantile::linear(int i, int direction) const {
+    return _heights[i] + direction * (_heights[i + direction] - _heights[i]) /
+                         (_positions[i + direction] - _positions[i]);
+}
+
+/*
+ * The first five values just fill the markers. After that, each value bumps the positions
+ * of the markers above it, and each middle marker that has drifted at least one position
+ * from where it should be is moved one step and given a new height.
+ */
+void P2Quantile::add(double value) {
+    if (_count < 5) {
+        _heights[_count++] = value;
+        if (_count == 5) {
+            sortSmall(_heights, 5);
+        }
+        return;
+    }
+    _count++;
+
+    int cell;
+    if (value < _heights[0]) {
+        _heights[0] = value;
+        cell = 0;
+    }
+    else if (value >= _heights[4]) {
+        _heights[4] = value;
+        cell = 3;
+    }
+    else {
+        cell = 0;
+        while (value >= _heights[cell + 1]) {
+            cell++;
+        }
+    }
+
+    for (int i = cell + 1; i < 5; i++) {
+        _positions[i]++;
+    }
+    for (int i = 0; i < 5; i++) {
+        _desired[i] += _increments[i];
+    }
+
+    for (int i = 1; i <= 3; i++) {
+        double drift = _desired[i] - _positions[i];
+        if ((drift >= 1 && _positions[i + 1] - _positions[i] > 1) ||
+            (drift <= -1 && _positions[i - 1] - _positions[i] < -1)) {
+            int direction = drift > 0 ? 1 : -1;
+            double height = parabolic(i, direction);
+            if (_heights[i - 1] < height && height < _heights[i + 1]) {
+                _heights[i] = height;
+            }
+            else {
+                _heights[i] = linear(i, direction);
+            }
+            _positions[i] += direction;
+        }
+    }
+}
+
+double P2Quantile::quantile() const {
+    if (_count == 0) {
+        error("P2Quantile: no values added");
+    }
+    if (_count < 5) {
+        double first[5];
+        copy(_heights, _heights + _count, first);
+        sortSmall(first, _count);
+        return first[quantileRank(_q, _count) - 1];
+    }
+    return _heights[2];
+}
+
+int P2Quantile::size() const {
+    return _count;
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+/* Helper function: nearest-rank q-quantile of values by sorting a copy, the slow way. */
+static int sortedQuantile(Vector<int> values, double q) {
+    sort(values.begin(), values.end());
+    return values[quantileRank(q, values.size()) - 1];
+}
+
+STUDENT_TEST("RunningQuantile matches sorting after every add") {
+    for (double q : { 0.0, 0.1, 0.5, 0.9, 0.99, 1.0 }) {
+        RunningQuantile running(q);
+        Vector<int> seen;
+        for (int i = 0; i < 1000; i++) {
+            int value = randomInteger(-50, 50);
+            running.add(value);
+            seen.add(value);
+            EXPECT_EQUAL(running.quantile(), sortedQuantile(seen, q));
+        }
+        EXPECT_EQUAL(running.size(), 1000);
+    }
+
+    RunningMedian median;
+    EXPECT_ERROR(median.quantile());
+    median.add(DataPoint{ "", -2147483647 - 1 });
+    median.add(2147483647);
+    median.add(0);
+    EXPECT_EQUAL(median.quantile(), 0);
+    EXPECT_ERROR(RunningQuantile(1.5));
+}
+
+STUDENT_TEST("SlidingWindowQuantile matches sorting the window after every add") {
+    for (int windowSize : { 1, 5, 64 }) {
+        SlidingWindowQuantile sliding(0.9, windowSize);
+        Vector<int> all;
+        for (int i = 0; i < 2000; i++) {
+            // few distinct values, so lots of duplicates leave the window
+            int value = randomInteger(0, 20);
+            sliding.add(value);
+            all.add(value);
+            int start = max(0, all.size() - windowSize);
+            EXPECT_EQUAL(sliding.quantile(), sortedQuantile(all.subList(start, all.size() - start), 0.9));
+        }
+        EXPECT_EQUAL(sliding.size(), windowSize);
+    }
+    EXPECT_ERROR(SlidingWindowQuantile(0.5, 0));
+}
+
+STUDENT_TEST("P2Quantile stays close to the true quantile in fixed memory") {
+    for (double q : { 0.5, 0.9, 0.99 }) {
+        P2Quantile approx(q);
+        Vector<int> seen;
+        for (int i = 0; i < 100000; i++) {
+            int value = randomInteger(0, 100000);
+            approx.add(value);
+            seen.add(value);
+        }
+        double exact = sortedQuantile(seen, q);
+        EXPECT(fabs(approx.quantile() - exact) < 1000);   // within 1% of the range
+    }
+
+    P2Quantile small(0.5);
+    small.add(3);
+    small.add(1);
+    small.add(2);
+    EXPECT_EQUAL(small.quantile(), 2);
+    EXPECT_ERROR(P2Quantile(0));
+}
+
+/* Helper functions for the time trial below: a median query after every add. */
+static void medianByResorting(const Vector<int>& values) {
+    Vector<DataPoint> seen;
+    for (int value : values) {
+        seen.add({ "", value });
+        Vector<DataPoint> copy = seen;
+        pqSort(copy);
+    }
+}
+
+static void medianByHeaps(const Vector<int>& values) {
+    RunningMedian median;
+    for (int value : values) {
+        median.add(value);
+        median.quantile();
+    }
+}
+
+STUDENT_TEST("Running median vs re-sorting with pqSort: time trial, query after every add") {
+    for (int n = 500; n <= 2000; n *= 2) {
+        Vector<int> values;
+        for (int i = 0; i < n; i++) {
+            values.add(randomInteger(1, n));
+        }
+        TIME_OPERATION(n, medianByResorting(values));
+        TIME_OPERATION(n, medianByHeaps(values));
+    }
+}
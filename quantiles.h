@@ -0,0 +1,166 @@
+/* File: quantiles.h
+ * Assignment brief: streaming median / quantile estimators over DataPoint priorities, using a
+ * pair of PQHeaps instead of re-sorting with pqSort for every query.
+ */
+#pragma once
+#include "testing/MemoryUtils.h"
+#include "datapoint.h"
+#include "hashmap.h"
+#include "pqheap.h"
+#include "queue.h"
+
+/**
+ * Exact running q-quantile (nearest-rank: the ceil(q * n)-th smallest of the n values seen,
+ * or the smallest if that rank is 0). The smallest ceil(q * n) values are kept in a
+ * max-heap and the rest in a min-heap, so the answer is always at the top of the
+ * max-heap.
+ *
+ * PQHeap is a min-heap, so the max-heap stores ~priority (bitwise not), which reverses the
+ * order of every int, including INT_MIN.
+ */
+class RunningQuantile {
+public:
+    /**
+     * Creates an empty estimator for quantile q, e.g. 0.5 for the median or 0.99 for p99.
+     *
+     * Reports an error if q is not between 0 and 1.
+     */
+    RunningQuantile(double q);
+
+    /**
+     * Adds one value. This operation runs in time O(log n).
+     */
+    void add(int priority);
+
+    /**
+     * Convenience for add(point.priority).
+     */
+    void add(const DataPoint& point);
+
+    /**
+     * Returns the current q-quantile. This operation runs in time O(1).
+     *
+     * Reports an error if no values have been added.
+     */
+    int quantile() const;
+
+    /**
+     * Returns the number of values added so far.
+     */
+    int size() const;
+
+private:
+    double _q;
+    PQHeap _low;    // max-heap (stored as ~priority) of the smallest ceil(q * n) values
+    PQHeap _high;   // min-heap of the remaining values
+
+    void rebalance();
+
+    DISALLOW_COPYING_OF(RunningQuantile);
+};
+
+/**
+ * Exact running median: RunningQuantile(0.5), i.e. the lower median.
+ */
+class RunningMedian : public RunningQuantile {
+public:
+    RunningMedian() : RunningQuantile(0.5) {}
+};
+
+/**
+ * Exact q-quantile of the last windowSize values. Uses the same pair of heaps as
+ * RunningQuantile. When a value leaves the window it is not searched for: its side is
+ * worked out from the heap tops and it is recorded in a pending-deletion count. Pending
+ * values are thrown away once they reach the top of their heap (lazy deletion). If
+ * deleted values pile up to more than the window size, both heaps are rebuilt from the
+ * window, which keeps memory O(windowSize). Each update costs amortized O(log windowSize).
+ */
+class SlidingWindowQuantile {
+public:
+    /**
+     * Creates an empty estimator for quantile q over the last windowSize values.
+     *
+     * Reports an error if q is not between 0 and 1 or windowSize is not positive.
+     */
+    SlidingWindowQuantile(double q, int windowSize);
+
+    /**
+     * Adds one value, pushing the oldest one out of the window if the window is full.
+     */
+    void add(int priority);
+
+    /**
+     * Returns the q-quantile of the values in the window.
+     *
+     * Reports an error if no values have been added.
+     */
+    int quantile() const;
+
+    /**
+     * Returns the number of values currently in the window.
+     */
+    int size() const;
+
+private:
+    double _q;
+    int _windowSize;
+    Queue<int> _window;             // values in the window, oldest first
+    PQHeap _low;                    // max-heap (stored as ~priority), may contain deleted values
+    PQHeap _high;                   // min-heap, may contain deleted values
+    int _lowSize;                   // number of live values in _low
+    int _highSize;                  // number of live values in _high
+    HashMap<int, int> _pendingLow;  // value -> how many deleted copies are still in _low
+    HashMap<int, int> _pendingHigh; // value -> how many deleted copies are still in _high
+
+    void remove(int priority);
+    void rebalance();
+    void prune(PQHeap& heap, HashMap<int, int>& pending, bool negated);
+    void rebuild();
+
+    DISALLOW_COPYING_OF(SlidingWindowQuantile);
+};
+
+/**
+ * Approximate q-quantile for unbounded streams in fixed memory, using the P-squared
+ * algorithm (Jain and Chlamtac, 1985). Five markers track the minimum, the maximum, the
+ * q-quantile and two points halfway to it. Their heights are adjusted with a parabolic
+ * formula as values arrive. Each update is O(1) and memory never grows.
+ */
+class P2Quantile {
+public:
+    /**
+     * Creates an empty estimator for quantile q.
+     *
+     * Reports an error if q is not strictly between 0 and 1.
+     */
+    P2Quantile(double q);
+
+    /**
+     * Adds one value. This operation runs in time O(1).
+     */
+    void add(double value);
+
+    /**
+     * Returns the current estimate of the q-quantile. Exact while fewer than five values
+     * have been added.
+     *
+     * Reports an error if no values have been added.
+     */
+    double quantile() const;
+
+    /**
+     * Returns the number of values added so far.
+     */
+    int size() const;
+
+private:
+    double _q;
+    int _count;
+    double _heights[5];     // marker heights (estimates of the min, q/2, q, (1+q)/2, max quantiles)
+    double _positions[5];   // actual marker positions (1-based ranks)
+    double _desired[5];     // desired marker positions
+    double _increments[5];  // how far each desired position moves per value
+
+    double parabolic(int i, int direction) const;
+    double linear(int i, int direction) const;
+};
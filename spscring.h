@@ -0,0 +1,95 @@
+/* File: spscring.h
+ * Assignment brief: lock-free single-producer / single-consumer ring buffer, used to hand
+ * batches of parsed DataPoints from a parser thread to a heap thread.
+ */
+#pragma once
+#include "testing/MemoryUtils.h"
+#include "error.h"
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Fixed-capacity ring of T slots shared by exactly one producer thread and one consumer
+ * thread. No locks are taken. The producer and consumer each own one index, and
+ * publish it to the other with release/acquire atomics.
+ *
+ * Slots are filled and drained in place, not copied: the producer asks for the next
+ * free slot with beginWrite(), fills it, and publishes it with endWrite(). The consumer
+ * gets it from beginRead() and hands it back with endRead(). The same slot objects are
+ * reused forever, so anything they own (e.g. string storage) is recycled too.
+ */
+template <typename T>
+class SpscRing {
+public:
+    /**
+     * Creates a ring with room for capacity slots.
+     *
+     * Reports an error if capacity is not positive.
+     */
+    SpscRing(int capacity) : _writeIndex(0), _readIndex(0) {
+        if (capacity <= 0) {
+            error("SpscRing: capacity must be positive");
+        }
+        _capacity = capacity;
+        _slots = new T[capacity];
+    }
+
+    /**
+     * Cleans up the slots.
+     */
+    ~SpscRing() {
+        delete[] _slots;
+    }
+
+    /**
+     * Producer only. Returns the next free slot, or nullptr if the ring is full (the
+     * consumer has fallen behind and the producer should wait).
+     */
+    T* beginWrite() {
+        size_t write = _writeIndex.load(std::memory_order_relaxed);
+        if (write - _readIndex.load(std::memory_order_acquire) == (size_t) _capacity) {
+            return nullptr;
+        }
+        return &_slots[write % _capacity];
+    }
+
+    /**
+     * Producer only. Publishes the slot returned by the last beginWrite().
+     */
+    void endWrite() {
+        _writeIndex.store(_writeIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+     * Consumer only. Returns the oldest published slot, or nullptr if the ring is empty.
+     */
+    T* beginRead() {
+        size_t read = _readIndex.load(std::memory_order_relaxed);
+        if (read == _writeIndex.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &_slots[read % _capacity];
+    }
+
+    /**
+     * Consumer only. Returns the slot from the last beginRead() to the producer.
+     */
+    void endRead() {
+        _readIndex.store(_readIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+     * Returns the number of slots in the ring.
+     */
+    int capacity() const {
+        return _capacity;
+    }
+
+private:
+    T* _slots;
+    int _capacity;
+    alignas(64) std::atomic<size_t> _writeIndex;    // count of slots ever published; written by producer
+    alignas(64) std::atomic<size_t> _readIndex;     // count of slots ever released; written by consumer
+
+    DISALLOW_COPYING_OF(SpscRing);
+};
@@ -0,0 +1,301 @@
+/* File: topksummary.cpp
+ * Assignment brief: mergeable, serializable topK summaries, so topK can run separately on
+ * each shard of the input and the partial results combine into the exact global top k.
+ * The header file, "topksummary.h" is in this repository.
+ */
+#include "topksummary.h"
+#include "dpbinary.h"
+#include "byteio.h"
+#include "pqclient.h"
+#include "error.h"
+#include "random.h"
+#include "strlib.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#ifndef _WIN32
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#endif
+extern char** environ;
+#endif
+#include "testing/SimpleTest.h"
+using namespace std;
+
+const string kSummaryMagic = "TKS1";
+
+/* Environment variables that tell a copy of this program it is a shard process. */
+const char* const kShardPathVariable = "TOPK_SHARD_PATH";
+const char* const kShardKVariable = "TOPK_SHARD_K";
+const char* const kShardBlobVariable = "TOPK_SHARD_BLOB";
+
+TopKSummary::TopKSummary(int k) {
+    if (k < 0) {
+        error("TopKSummary: k must not be negative");
+    }
+    _k = k;
+}
+
+void TopKSummary::add(const DataPoint& point) {
+    offerTopK(_heap, point, _k);
+}
+
+int TopKSummary::size() const {
+    return _heap.size();
+}
+
+/*
+ * PQHeap can't be walked without removing elements, so drain it and then put
+ * everything back.
+ */
+Vector<DataPoint> TopKSummary::results() {
+    Vector<DataPoint> result = drainDescending(_heap);
+    for (const DataPoint& point : result) {
+        _heap.enqueue(point);
+    }
+    return result;
+}
+
+string TopKSummary::serialize() {
+    string header = kSummaryMagic;
+    appendU32(header, _k);
+    stringstream out;
+    out << header;
+    BinaryDataPointWriter writer(out);
+    for (const DataPoint& point : results()) {
+        writer.write(point);
+    }
+    writer.close();
+    return out.str();
+}
+
+void TopKSummary::merge(const string& blob) {
+    if (blob.size() < 8 || blob.substr(0, 4) != kSummaryMagic) {
+        error("TopKSummary: not a summary blob");
+    }
+    int blobK = readU32(blob.data(), 4);
+    if (blobK < _k) {
+        error("TopKSummary: blob was built with k = " + integerToString(blobK) +
+              ", too small to merge into k = " + integerToString(_k));
+    }
+    stringstream in(blob.substr(8));
+    BinaryDataPointReader reader(in);
+    DataPoint point;
+    while (reader.next(point)) {
+        add(point);
+    }
+}
+
+Vector<DataPoint> mergeTopKSummaries(const Vector<string>& blobs, int k) {
+    TopKSummary summary(k);
+    for (const string& blob : blobs) {
+        summary.merge(blob);
+    }
+    return summary.results();
+}
+
+/* HELPER FUNCTION: the work done for one shard. Reads the text DataPoints in shardPath and
+ * writes the serialized summary to blobPath.
+ */
+static void summarizeShard(const string& shardPath, int k, const string& blobPath) {
+    ifstream in(shardPath);
+    if (!in) {
+        error("runShardedTopK: cannot open shard " + shardPath);
+    }
+    TopKSummary summary(k);
+    DataPoint point;
+    while (in >> point) {
+        summary.add(point);
+    }
+    ofstream out(blobPath, ios::binary);
+    out << summary.serialize();
+    if (!out) {
+        error("runShardedTopK: cannot write " + blobPath);
+    }
+}
+
+#ifndef _WIN32
+/*
+ * A shard process is this same program, started again by runShardedTopK with its shard
+ * named in the environment. It does its shard while static objects are being set up,
+ * before main() runs any tests, and exits with status 0 if the blob was written. What it
+ * uses from other files is constant-initialized, so it doesn't matter whether their
+ * statics have been set up yet.
+ */
+static int runShardProcessIfAsked() {
+    const char* shardPath = getenv(kShardPathVariable);
+    const char* k = getenv(kShardKVariable);
+    const char* blobPath = getenv(kShardBlobVariable);
+    if (shardPath == nullptr || k == nullptr || blobPath == nullptr) {
+        return 0;
+    }
+    try {
+        summarizeShard(shardPath, stringToInteger(k), blobPath);
+    } catch (...) {
+        _exit(1);
+    }
+    _exit(0);
+}
+
+static int shardProcessStatus = runShardProcessIfAsked();
+
+/* HELPER FUNCTION: returns the path of the running program, for starting it again. */
+static string selfPath() {
+#ifdef __APPLE__
+    char path[4096];
+    uint32_t size = sizeof(path);
+    if (_NSGetExecutablePath(path, &size) != 0) {
+        error("runShardedTopK: cannot find the running program");
+    }
+    return path;
+#else
+    return "/proc/self/exe";
+#endif
+}
+
+/* HELPER FUNCTION: starts this program again as the shard process for one shard and
+ * returns its pid. The child is exec'd straight away by posix_spawn, so nothing of this
+ * process's threads, locks or buffers carries over.
+ */
+static pid_t startShardProcess(const string& program, const string& shardPath, int k, const string& blobPath) {
+    Vector<string> settings = {
+        string(kShardPathVariable) + "=" + shardPath,
+        string(kShardKVariable) + "=" + integerToString(k),
+        string(kShardBlobVariable) + "=" + blobPath
+    };
+    Vector<char*> envp;
+    for (char** var = environ; *var != nullptr; var++) {
+        envp.add(*var);
+    }
+    for (string& setting : settings) {
+        envp.add(&setting[0]);
+    }
+    envp.add(nullptr);
+    string arg0 = program;
+    char* argv[] = { &arg0[0], nullptr };
+
+    pid_t pid;
+    if (posix_spawn(&pid, program.c_str(), nullptr, nullptr, argv, &envp[0]) != 0) {
+        return -1;
+    }
+    return pid;
+}
+#endif
+
+/*
+ * Each child process only ever talks to the parent through its blob file, the same way
+ * separate machines would. A child that hits an error exits with a nonzero status,
+ * which the parent reports.
+ */
+Vector<DataPoint> runShardedTopK(const Vector<string>& shardPaths, int k, const string& workDirectory) {
+    string prefix = workDirectory + "/topk_" + integerToString(randomInteger(0, 999999999)) + "_";
+    Vector<string> blobPaths;
+    for (int i = 0; i < shardPaths.size(); i++) {
+        blobPaths.add(prefix + integerToString(i) + ".tks");
+    }
+
+#ifndef _WIN32
+    string program = selfPath();
+    Vector<pid_t> children;
+    bool failed = false;
+    for (int i = 0; i < shardPaths.size(); i++) {
+        pid_t pid = startShardProcess(program, shardPaths[i], k, blobPaths[i]);
+        if (pid < 0) {
+            failed = true;
+            break;
+        }
+        children.add(pid);
+    }
+    for (pid_t pid : children) {
+        int status = 0;
+        if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            failed = true;
+        }
+    }
+    if (failed) {
+        for (const string& path : blobPaths) {
+            remove(path.c_str());
+        }
+        error("runShardedTopK: a shard process failed");
+    }
+#else
+    for (int i = 0; i < shardPaths.size(); i++) {
+        summarizeShard(shardPaths[i], k, blobPaths[i]);
+    }
+#endif
+
+    Vector<string> blobs;
+    for (const string& path : blobPaths) {
+        ifstream in(path, ios::binary);
+        stringstream contents;
+        contents << in.rdbuf();
+        blobs.add(contents.str());
+        remove(path.c_str());
+    }
+    return mergeTopKSummaries(blobs, k);
+}
+
+
+/* * * * * * Test Cases Below This Point * * * * * */
+
+STUDENT_TEST("TopKSummary serialize/merge round trip gives the exact top k") {
+    Vector<DataPoint> all;
+    Vector<string> blobs;
+    for (int shard = 0; shard < 5; shard++) {
+        TopKSummary summary(10);
+        for (int i = 0; i < 2000; i++) {
+            DataPoint point = { "s" + integerToString(shard), randomInteger(1, 1000000) };
+            summary.add(point);
+            all.add(point);
+        }
+        EXPECT_EQUAL(summary.size(), 10);
+        blobs.add(summary.serialize());
+        // 4 + 4 header, 4 for "DPB1", one 8-byte block header, 8 + 2 bytes per record, 8-byte end marker
+        EXPECT_EQUAL((int) blobs[shard].size(), 12 + 8 + 10 * 10 + 8);
+    }
+
+    Vector<DataPoint> expected = topK(all, 10);
+    Vector<DataPoint> merged = mergeTopKSummaries(blobs, 10);
+    EXPECT_EQUAL(merged.size(), 10);
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQUAL(merged[i].priority, expected[i].priority);
+    }
+
+    // a smaller k can be answered from bigger summaries, but not the other way around
+    EXPECT_EQUAL(mergeTopKSummaries(blobs, 3).size(), 3);
+    EXPECT_ERROR(mergeTopKSummaries(blobs, 11));
+    EXPECT_ERROR(mergeTopKSummaries({ "not a blob" }, 1));
+    EXPECT_EQUAL(mergeTopKSummaries({}, 5), Vector<DataPoint>());
+}
+
+STUDENT_TEST("runShardedTopK: one process per shard file, blobs through files") {
+    Vector<string> shardPaths;
+    Vector<DataPoint> all;
+    for (int shard = 0; shard < 4; shard++) {
+        string path = "topk_shard_" + integerToString(shard) + ".txt";
+        ofstream out(path);
+        for (int i = 0; i < 5000; i++) {
+            DataPoint point = { "", randomInteger(1, 1000000) };
+            out << point;
+            all.add(point);
+        }
+        shardPaths.add(path);
+    }
+
+    Vector<DataPoint> expected = topK(all, 25);
+    Vector<DataPoint> result = runShardedTopK(shardPaths, 25, ".");
+    EXPECT_EQUAL(result.size(), 25);
+    for (int i = 0; i < 25; i++) {
+        EXPECT_EQUAL(result[i].priority, expected[i].priority);
+    }
+
+    shardPaths.add("no_such_shard.txt");
+    EXPECT_ERROR(runShardedTopK(shardPaths, 25, "."));
+    for (const string& path : shardPaths) {
+        remove(path.c_str());
+    }
+}
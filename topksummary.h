@@ -0,0 +1,81 @@
+/* File: topksummary.h
+ * Assignment brief: mergeable, serializable topK summaries, so topK can run separately on
+ * each shard of the input and the partial results combine into the exact global top k.
+ */
+#pragma once
+#include "testing/MemoryUtils.h"
+#include "datapoint.h"
+#include "pqheap.h"
+#include "vector.h"
+#include <string>
+
+/**
+ * The k highest-weight DataPoints seen so far, held in a size-k PQHeap. A summary can be
+ * turned into a compact byte blob and sent to another process. Merging the blobs of
+ * summaries built over disjoint parts of a stream gives exactly the top k of the
+ * whole stream, because each global top-k element is in the top k of its own part.
+ */
+class TopKSummary {
+public:
+    /**
+     * Creates an empty summary that keeps the top k elements.
+     *
+     * Reports an error if k is negative.
+     */
+    TopKSummary(int k);
+
+    /**
+     * Offers point to the summary. This operation runs in time O(log k).
+     */
+    void add(const DataPoint& point);
+
+    /**
+     * Offers every element of blob (made by serialize()) to this summary.
+     *
+     * Reports an error if blob is malformed, or if it was built with a smaller k than
+     * this summary (its elements would not be enough to give an exact top k).
+     */
+    void merge(const std::string& blob);
+
+    /**
+     * Returns the summary's elements sorted in descending order of weight. The summary
+     * itself is unchanged.
+     */
+    Vector<DataPoint> results();
+
+    /**
+     * Returns a compact byte blob holding k and the summary's elements: a "TKS1"
+     * header, k as 4 little-endian bytes, then the elements in the binary DataPoint
+     * format from dpbinary.h.
+     */
+    std::string serialize();
+
+    /**
+     * Returns the number of elements in the summary, at most k.
+     */
+    int size() const;
+
+private:
+    int _k;
+    PQHeap _heap;
+
+    DISALLOW_COPYING_OF(TopKSummary);
+};
+
+/**
+ * Merges any number of blobs made by TopKSummary::serialize() and returns the global top k,
+ * sorted in descending order of weight.
+ */
+Vector<DataPoint> mergeTopKSummaries(const Vector<std::string>& blobs, int k);
+
+/**
+ * Local multi-process harness. Starts one child process per shard file (each holding
+ * text-format DataPoints) by running this program again with the shard named in its
+ * environment. Each child builds a TopKSummary of its shard and writes the blob to a file
+ * in workDirectory. The parent waits for every child, then merges the blob files and
+ * returns the global top k. On Windows the shards are summarized one after another in
+ * this process, still going through the blob files.
+ *
+ * Reports an error if a shard cannot be read or a child process fails.
+ */
+Vector<DataPoint> runShardedTopK(const Vector<std::string>& shardPaths, int k, const std::string& workDirectory);
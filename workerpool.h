@@ -0,0 +1,137 @@
+/* File: workerpool.h
+ * Assignment brief: a fixed pool of worker threads for the parallel block codec in
+ * huffmanstream. The threads are started once and reused for every batch of blocks,
+ * so nothing is spawned per block.
+ */
+#pragma once
+#include "testing/MemoryUtils.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Runs batches of independent jobs on numThreads threads: numThreads - 1 workers started
+ * by the constructor, plus the thread that calls run(). Jobs are numbered, and each
+ * thread takes the next unclaimed number from a shared counter until none are left, so
+ * a slow job never holds up the others.
+ */
+class WorkerPool {
+public:
+    /**
+     * Starts the workers. numThreads = 0 means one per hardware thread.
+     */
+    WorkerPool(int numThreads = 0) : _job(nullptr), _numJobs(0), _next(0), _active(0),
+                                     _generation(0), _stopping(false) {
+        if (numThreads <= 0) {
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (int i = 1; i < numThreads; i++) {
+            _workers.emplace_back(&WorkerPool::workerLoop, this);
+        }
+    }
+
+    /**
+     * Stops and joins the workers.
+     */
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _wake.notify_all();
+        for (std::thread& worker : _workers) {
+            worker.join();
+        }
+    }
+
+    /**
+     * Returns the number of threads that run jobs, counting the caller of run().
+     */
+    int size() const {
+        return _workers.size() + 1;
+    }
+
+    /**
+     * Calls job(0), job(1), ..., job(numJobs - 1), each exactly once, spread over the
+     * pool, and returns when all of them have finished. If any job throws, the remaining
+     * unstarted jobs are skipped and the first exception is rethrown here.
+     */
+    void run(int numJobs, const std::function<void(int)>& job) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _job = &job;
+            _numJobs = numJobs;
+            _next = 0;
+            _failure = nullptr;
+            _active = _workers.size();
+            _generation++;
+        }
+        _wake.notify_all();
+        drain();
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [this]() { return _active == 0; });
+        _job = nullptr;
+        if (_failure) {
+            std::rethrow_exception(_failure);
+        }
+    }
+
+private:
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _wake;      // workers wait here for the next batch
+    std::condition_variable _done;      // run() waits here for the workers to finish one
+    const std::function<void(int)>* _job;
+    int _numJobs;
+    std::atomic<int> _next;             // next unclaimed job number
+    int _active;                        // workers still on the current batch
+    uint64_t _generation;               // count of batches started; tells workers a new one is ready
+    bool _stopping;
+    std::exception_ptr _failure;
+
+    /* Claims and runs jobs from the current batch until there are none left. */
+    void drain() {
+        while (true) {
+            int index = _next++;
+            if (index >= _numJobs) {
+                return;
+            }
+            try {
+                (*_job)(index);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (!_failure) {
+                    _failure = std::current_exception();
+                }
+                _next = _numJobs;
+            }
+        }
+    }
+
+    /* Body of each worker: waits for a batch, helps drain it, reports back, repeats. */
+    void workerLoop() {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            _wake.wait(lock, [&]() { return _stopping || _generation != seen; });
+            if (_stopping) {
+                return;
+            }
+            seen = _generation;
+            lock.unlock();
+            drain();
+            lock.lock();
+            if (--_active == 0) {
+                _done.notify_all();
+            }
+        }
+    }
+
+    DISALLOW_COPYING_OF(WorkerPool);
+};